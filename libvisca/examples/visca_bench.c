@@ -0,0 +1,575 @@
+/*
+ * VISCA(tm) Camera Control Library Benchmark
+ * Copyright (C) 2002 Damien Douxchamps 
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Round trip latency of every command and inquiry, on a camera or on the
+ * simulator. For each one it reports the 50th, 95th and 99th percentile
+ * latency, the calls per second and the read and write system calls per
+ * call, as a table, CSV or JSON.
+ *
+ * Beware that on a real camera this changes its settings.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../visca/libvisca.h"
+
+static VISCATitleData_t title;
+
+/* One entry per VISCA_* function: CMD passes the given arguments, GET
+ * pointers to 1 to 3 values of the given type.
+ */
+#define BENCH_COMMANDS \
+  CUSTOM(set_address) \
+  CMD(clear) \
+  CMD(get_camera_info) \
+  CMD(set_power, 2) \
+  CMD(set_keylock, 2) \
+  CMD(set_camera_id, 1) \
+  CMD(set_zoom_tele) \
+  CMD(set_zoom_wide) \
+  CMD(set_zoom_stop) \
+  CMD(set_zoom_tele_speed, 2) \
+  CMD(set_zoom_wide_speed, 2) \
+  CMD(set_zoom_value, 0) \
+  CMD(set_zoom_and_focus_value, 0x0000, 0x1000) \
+  CMD(set_dzoom, 2) \
+  CMD(set_dzoom_limit, 0) \
+  CMD(set_dzoom_mode, 2) \
+  CMD(set_focus_far) \
+  CMD(set_focus_near) \
+  CMD(set_focus_stop) \
+  CMD(set_focus_far_speed, 2) \
+  CMD(set_focus_near_speed, 2) \
+  CMD(set_focus_value, 0x1000) \
+  CMD(set_focus_auto, 2) \
+  CMD(set_focus_one_push) \
+  CMD(set_focus_infinity) \
+  CMD(set_focus_autosense_high) \
+  CMD(set_focus_autosense_low) \
+  CMD(set_focus_near_limit, 0x1000) \
+  CMD(set_whitebal_mode, 0) \
+  CMD(set_whitebal_one_push) \
+  CMD(set_rgain_up) \
+  CMD(set_rgain_down) \
+  CMD(set_rgain_reset) \
+  CMD(set_rgain_value, 0) \
+  CMD(set_bgain_up) \
+  CMD(set_bgain_down) \
+  CMD(set_bgain_reset) \
+  CMD(set_bgain_value, 0) \
+  CMD(set_shutter_up) \
+  CMD(set_shutter_down) \
+  CMD(set_shutter_reset) \
+  CMD(set_shutter_value, 0) \
+  CMD(set_iris_up) \
+  CMD(set_iris_down) \
+  CMD(set_iris_reset) \
+  CMD(set_iris_value, 0) \
+  CMD(set_gain_up) \
+  CMD(set_gain_down) \
+  CMD(set_gain_reset) \
+  CMD(set_gain_value, 0) \
+  CMD(set_bright_up) \
+  CMD(set_bright_down) \
+  CMD(set_bright_reset) \
+  CMD(set_bright_value, 0) \
+  CMD(set_aperture_up) \
+  CMD(set_aperture_down) \
+  CMD(set_aperture_reset) \
+  CMD(set_aperture_value, 0) \
+  CMD(set_exp_comp_up) \
+  CMD(set_exp_comp_down) \
+  CMD(set_exp_comp_reset) \
+  CMD(set_exp_comp_value, 0) \
+  CMD(set_exp_comp_power, 2) \
+  CMD(set_auto_exp_mode, 0) \
+  CMD(set_slow_shutter_auto, 2) \
+  CMD(set_backlight_comp, 2) \
+  CMD(set_zero_lux_shot, 2) \
+  CMD(set_ir_led, 2) \
+  CMD(set_wide_mode, 0) \
+  CMD(set_mirror, 2) \
+  CMD(set_freeze, 2) \
+  CMD(set_picture_effect, 0) \
+  CMD(set_digital_effect, 0) \
+  CMD(set_digital_effect_level, 0) \
+  CMD(set_cam_stabilizer, 2) \
+  CMD(memory_set, 0) \
+  CMD(memory_recall, 0) \
+  CMD(memory_reset, 0) \
+  CMD(set_display, 2) \
+  CMD(set_date_time, 0, 1, 1, 0, 0) \
+  CMD(set_date_display, 2) \
+  CMD(set_time_display, 2) \
+  CMD(set_title_display, 2) \
+  CMD(set_title_clear) \
+  CMD(set_title_params, &title) \
+  CMD(set_title, &title) \
+  CMD(set_spot_ae_on) \
+  CMD(set_spot_ae_off) \
+  CMD(set_spot_ae_position, 0, 0) \
+  GET(get_power, uint8_t) \
+  GET(get_dzoom, uint8_t) \
+  GET(get_dzoom_limit, uint8_t) \
+  GET(get_zoom_value, uint16_t) \
+  GET(get_focus_auto, uint8_t) \
+  GET(get_focus_value, uint16_t) \
+  GET(get_focus_auto_sense, uint8_t) \
+  GET(get_focus_near_limit, uint16_t) \
+  GET(get_whitebal_mode, uint8_t) \
+  GET(get_rgain_value, uint16_t) \
+  GET(get_bgain_value, uint16_t) \
+  GET(get_auto_exp_mode, uint8_t) \
+  GET(get_slow_shutter_auto, uint8_t) \
+  GET(get_shutter_value, uint16_t) \
+  GET(get_iris_value, uint16_t) \
+  GET(get_gain_value, uint16_t) \
+  GET(get_bright_value, uint16_t) \
+  GET(get_exp_comp_power, uint8_t) \
+  GET(get_exp_comp_value, uint16_t) \
+  GET(get_backlight_comp, uint8_t) \
+  GET(get_aperture_value, uint16_t) \
+  GET(get_zero_lux_shot, uint8_t) \
+  GET(get_ir_led, uint8_t) \
+  GET(get_wide_mode, uint8_t) \
+  GET(get_mirror, uint8_t) \
+  GET(get_freeze, uint8_t) \
+  GET(get_picture_effect, uint8_t) \
+  GET(get_digital_effect, uint8_t) \
+  GET(get_digital_effect_level, uint16_t) \
+  GET(get_memory, uint8_t) \
+  GET(get_display, uint8_t) \
+  GET(get_id, uint16_t) \
+  CMD(set_irreceive_on) \
+  CMD(set_irreceive_off) \
+  CMD(set_irreceive_onoff) \
+  CMD(set_pantilt_up, 1, 1) \
+  CMD(set_pantilt_down, 1, 1) \
+  CMD(set_pantilt_left, 1, 1) \
+  CMD(set_pantilt_right, 1, 1) \
+  CMD(set_pantilt_upleft, 1, 1) \
+  CMD(set_pantilt_upright, 1, 1) \
+  CMD(set_pantilt_downleft, 1, 1) \
+  CMD(set_pantilt_downright, 1, 1) \
+  CMD(set_pantilt_stop, 1, 1) \
+  CMD(set_pantilt_absolute_position, 1, 1, 0, 0) \
+  CMD(set_pantilt_relative_position, 1, 1, 0, 0) \
+  CMD(set_pantilt_home) \
+  CMD(set_pantilt_reset) \
+  CMD(set_pantilt_limit_upright, 0, 0) \
+  CMD(set_pantilt_limit_downleft, 0, 0) \
+  CMD(set_pantilt_limit_downleft_clear) \
+  CMD(set_pantilt_limit_upright_clear) \
+  CMD(set_datascreen_on) \
+  CMD(set_datascreen_off) \
+  CMD(set_datascreen_onoff) \
+  CMD(set_register, 0, 0) \
+  GET(get_videosystem, uint8_t) \
+  GET(get_pantilt_mode, uint16_t) \
+  GET2(get_pantilt_maxspeed, uint8_t) \
+  GET2(get_pantilt_position, int) \
+  GET(get_datascreen, uint8_t) \
+  CUSTOM(get_register) \
+  CMD(set_wide_con_lens, 2) \
+  CMD(set_at_mode_onoff) \
+  CMD(set_at_mode, 2) \
+  CMD(set_at_ae_onoff) \
+  CMD(set_at_ae, 2) \
+  CMD(set_at_autozoom_onoff) \
+  CMD(set_at_autozoom, 2) \
+  CMD(set_atmd_framedisplay_onoff) \
+  CMD(set_atmd_framedisplay, 2) \
+  CMD(set_at_frameoffset_onoff) \
+  CMD(set_at_frameoffset, 2) \
+  CMD(set_atmd_startstop) \
+  CMD(set_at_chase, 2) \
+  CMD(set_at_chase_next) \
+  CMD(set_md_mode_onoff) \
+  CMD(set_md_mode, 2) \
+  CMD(set_md_frame) \
+  CMD(set_md_detect) \
+  CMD(set_at_entry, 2) \
+  CMD(set_at_lostinfo) \
+  CMD(set_md_lostinfo) \
+  CMD(set_md_adjust_ylevel, 2) \
+  CMD(set_md_adjust_huelevel, 2) \
+  CMD(set_md_adjust_size, 2) \
+  CMD(set_md_adjust_disptime, 2) \
+  CMD(set_md_adjust_refmode, 2) \
+  CMD(set_md_adjust_reftime, 2) \
+  CMD(set_md_measure_mode1_onoff) \
+  CMD(set_md_measure_mode1, 2) \
+  CMD(set_md_measure_mode2_onoff) \
+  CMD(set_md_measure_mode2, 2) \
+  GET(get_keylock, uint8_t) \
+  GET(get_wide_con_lens, uint8_t) \
+  GET(get_atmd_mode, uint8_t) \
+  GET(get_at_mode, uint16_t) \
+  GET(get_at_entry, uint8_t) \
+  GET(get_md_mode, uint16_t) \
+  GET(get_md_ylevel, uint8_t) \
+  GET(get_md_huelevel, uint8_t) \
+  GET(get_md_size, uint8_t) \
+  GET(get_md_disptime, uint8_t) \
+  GET(get_md_refmode, uint8_t) \
+  GET(get_md_reftime, uint8_t) \
+  GET3(get_at_obj_pos, uint8_t) \
+  GET3(get_md_obj_pos, uint8_t) \
+  CUSTOM(batch)
+
+
+#define CMD(name, ...) \
+  static uint32_t bench_##name(VISCAInterface_t *iface, VISCACamera_t *camera) \
+  { return VISCA_##name(iface, camera, ##__VA_ARGS__); }
+#define GET(name, type) \
+  static uint32_t bench_##name(VISCAInterface_t *iface, VISCACamera_t *camera) \
+  { type v1; return VISCA_##name(iface, camera, &v1); }
+#define GET2(name, type) \
+  static uint32_t bench_##name(VISCAInterface_t *iface, VISCACamera_t *camera) \
+  { type v1, v2; return VISCA_##name(iface, camera, &v1, &v2); }
+#define GET3(name, type) \
+  static uint32_t bench_##name(VISCAInterface_t *iface, VISCACamera_t *camera) \
+  { type v1, v2, v3; return VISCA_##name(iface, camera, &v1, &v2, &v3); }
+#define CUSTOM(name)
+
+BENCH_COMMANDS
+
+#undef CMD
+#undef GET
+#undef GET2
+#undef GET3
+#undef CUSTOM
+
+static uint32_t
+bench_set_address(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  int camera_num;
+
+  return VISCA_set_address(iface, &camera_num);
+}
+
+static uint32_t
+bench_get_register(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  uint8_t value;
+
+  return VISCA_get_register(iface, camera, 0, &value);
+}
+
+/* Commands in flight together: power off, a zoom stop the camera cannot
+ * carry out while off, and power on. Fails unless each command gets its
+ * own result back.
+ */
+static uint32_t
+bench_batch(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  static const unsigned char command[3][4] = {
+    { VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_POWER, VISCA_OFF },
+    { VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, VISCA_ZOOM_STOP },
+    { VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_POWER, VISCA_ON },
+  };
+  static const uint32_t expected[3] = {
+    VISCA_SUCCESS, VISCA_ERROR_CMD_NOT_EXECUTABLE, VISCA_SUCCESS
+  };
+  static VISCABatch_t batch;
+  VISCAPacket_t packet;
+  uint32_t i, j;
+
+  VISCA_batch_init(&batch, iface);
+  for (i=0; i<3; i++)
+    {
+      _VISCA_init_packet(&packet);
+      for (j=0; j<4; j++)
+	_VISCA_append_byte(&packet, command[i][j]);
+      VISCA_batch_add(&batch, camera, &packet);
+    }
+  VISCA_batch_run(&batch);
+
+  for (i=0; i<3; i++)
+    if (batch.result[i]!=expected[i])
+      return VISCA_FAILURE;
+
+  return VISCA_SUCCESS;
+}
+
+typedef struct
+{
+  const char *name;
+  uint32_t (*call)(VISCAInterface_t *iface, VISCACamera_t *camera);
+} bench_command_t;
+
+#define CMD(name, ...)    { #name, bench_##name },
+#define GET(name, type)   { #name, bench_##name },
+#define GET2(name, type)  { #name, bench_##name },
+#define GET3(name, type)  { #name, bench_##name },
+#define CUSTOM(name)      { #name, bench_##name },
+
+static const bench_command_t commands[] = {
+  BENCH_COMMANDS
+  { NULL, NULL }
+};
+
+
+typedef struct
+{
+  uint32_t calls;
+  uint32_t errors;
+  double p50, p95, p99, mean;   // us
+  double rate;                  // calls per second
+  double syscalls;              // per call, negative if unknown
+} bench_result_t;
+
+
+static uint64_t
+bench_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+
+/* Read and write system calls made so far by this thread, -1 where this
+ * is not known.
+ */
+static long long
+bench_syscalls(void)
+{
+  FILE *f;
+  char line[64];
+  long long value, total=0;
+  int found=0;
+
+  f=fopen("/proc/thread-self/io", "r");
+  if (f==NULL)
+    return -1;
+  while (fgets(line, sizeof(line), f)!=NULL)
+    if ((sscanf(line, "syscr: %lld", &value)==1)||(sscanf(line, "syscw: %lld", &value)==1))
+      {
+	total+=value;
+	found++;
+      }
+  fclose(f);
+
+  return (found==2) ? total : -1;
+}
+
+
+static int
+bench_compare(const void *a, const void *b)
+{
+  uint64_t x=*(const uint64_t *)a, y=*(const uint64_t *)b;
+
+  return (x<y) ? -1 : (x>y) ? 1 : 0;
+}
+
+
+/* nearest rank percentile of sorted samples, in us */
+static double
+bench_percentile(const uint64_t *samples, uint32_t count, uint32_t p)
+{
+  uint32_t rank=(p*count+99)/100;
+
+  return samples[(rank>0) ? rank-1 : 0]/1000.0;
+}
+
+
+static void
+bench_run(VISCAInterface_t *iface, VISCACamera_t *camera, const bench_command_t *cmd,
+	  uint32_t count, uint64_t *samples, bench_result_t *result)
+{
+  uint64_t start, t, total=0;
+  long long before, after, overhead;
+  uint32_t i;
+
+  // warm up, and measure what reading the counters costs
+  cmd->call(iface, camera);
+  before=bench_syscalls();
+  after=bench_syscalls();
+  overhead=after-before;
+
+  result->errors=0;
+  before=bench_syscalls();
+  start=bench_time();
+  for (i=0; i<count; i++)
+    {
+      t=bench_time();
+      if (cmd->call(iface, camera)!=VISCA_SUCCESS)
+	result->errors++;
+      samples[i]=bench_time()-t;
+    }
+  total=bench_time()-start;
+  after=bench_syscalls();
+
+  qsort(samples, count, sizeof(uint64_t), bench_compare);
+  result->calls=count;
+  result->p50=bench_percentile(samples, count, 50);
+  result->p95=bench_percentile(samples, count, 95);
+  result->p99=bench_percentile(samples, count, 99);
+  result->mean=total/1000.0/count;
+  result->rate=(total>0) ? count*1e9/total : 0;
+  result->syscalls=((before<0)||(after<0)) ? -1 : (double)(after-before-overhead)/count;
+}
+
+
+static void
+bench_print(const char *format, const char *name, const bench_result_t *r, int first)
+{
+  char syscalls[32];
+
+  if (r->syscalls<0)
+    strcpy(syscalls, (strcmp(format, "json")==0) ? "null" : "-");
+  else
+    snprintf(syscalls, sizeof(syscalls), "%.2f", r->syscalls);
+
+  if (strcmp(format, "csv")==0)
+    printf("%s,%u,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%s\n", name, r->calls, r->errors,
+	   r->p50, r->p95, r->p99, r->mean, r->rate, syscalls);
+  else if (strcmp(format, "json")==0)
+    printf("%s    {\"command\": \"%s\", \"calls\": %u, \"errors\": %u, \"p50_us\": %.1f, "
+	   "\"p95_us\": %.1f, \"p99_us\": %.1f, \"mean_us\": %.1f, \"calls_per_sec\": %.1f, "
+	   "\"syscalls_per_call\": %s}", first ? "" : ",\n", name, r->calls, r->errors,
+	   r->p50, r->p95, r->p99, r->mean, r->rate, syscalls);
+  else
+    printf("%-32s %6u %6u %10.1f %10.1f %10.1f %12.1f %9s\n", name, r->calls, r->errors,
+	   r->p50, r->p95, r->p99, r->rate, syscalls);
+}
+
+
+static void
+print_usage(const char *argv0)
+{
+  fprintf(stderr,"Usage: %s [-d <serial port device> [-b <baud rate>] | -t <host:port> |\n",argv0);
+  fprintf(stderr,"         -u <host[:port]> | -s <direct|socketpair|pty|udp> [-z]]\n");
+  fprintf(stderr,"         [-c <camera>] [-n <calls>] [-f <filter>] [-o <text|csv|json>]\n");
+  fprintf(stderr,"  -d  camera on a serial port      -t  camera on a serial-over-TCP bridge\n");
+  fprintf(stderr,"  -u  VISCA over IP camera         -s  simulator (default: direct)\n");
+  fprintf(stderr,"  -z  simulator without reply delays\n");
+  fprintf(stderr,"  -f  only the commands whose name contains filter\n");
+  exit(1);
+}
+
+
+int
+main(int argc, char **argv)
+{
+  VISCAInterface_t iface;
+  VISCACamera_t camera;
+  VISCASim_t sim;
+  const bench_command_t *cmd;
+  bench_result_t result;
+  const char *device=NULL, *tcp=NULL, *udp=NULL, *filter=NULL, *format="text";
+  uint32_t baud=9600, count=100, mode=VISCA_SIM_DIRECT, err;
+  uint64_t *samples;
+  int opt, instant=0, use_sim=1, first=1;
+
+  camera.address=1;
+
+  while ((opt=getopt(argc, argv, "d:b:t:u:s:zc:n:f:o:"))!=-1)
+    switch (opt)
+      {
+      case 'd': device=optarg; use_sim=0; break;
+      case 'b': baud=strtoul(optarg, NULL, 10); break;
+      case 't': tcp=optarg; use_sim=0; break;
+      case 'u': udp=optarg; use_sim=0; break;
+      case 's':
+	if (strcmp(optarg, "direct")==0)
+	  mode=VISCA_SIM_DIRECT;
+	else if (strcmp(optarg, "socketpair")==0)
+	  mode=VISCA_SIM_SOCKETPAIR;
+	else if (strcmp(optarg, "pty")==0)
+	  mode=VISCA_SIM_PTY;
+	else if (strcmp(optarg, "udp")==0)
+	  mode=VISCA_SIM_UDP;
+	else
+	  print_usage(argv[0]);
+	break;
+      case 'z': instant=1; break;
+      case 'c': camera.address=atoi(optarg); break;
+      case 'n': count=strtoul(optarg, NULL, 10); break;
+      case 'f': filter=optarg; break;
+      case 'o': format=optarg; break;
+      default: print_usage(argv[0]);
+      }
+  if ((count==0)||((strcmp(format, "text")!=0)&&(strcmp(format, "csv")!=0)&&(strcmp(format, "json")!=0)))
+    print_usage(argv[0]);
+
+  if (device!=NULL)
+    err=VISCA_open_serial_ext(&iface, device, baud, VISCA_SERIAL_DEFAULT);
+  else if (tcp!=NULL)
+    err=VISCA_open_transport(&iface, &VISCA_tcp_transport, tcp);
+  else if (udp!=NULL)
+    err=VISCA_open_transport(&iface, &VISCA_udp_transport, udp);
+  else
+    {
+      VISCA_sim_init(&sim, camera.address);
+      if (instant)
+	{
+	  sim.ack_delay=0;
+	  sim.completion_delay=0;
+	  sim.inquiry_delay=0;
+	}
+      err=VISCA_open_sim(&iface, &sim, mode);
+    }
+  if (err!=VISCA_SUCCESS)
+    {
+      fprintf(stderr,"%s: unable to open the interface\n",argv[0]);
+      exit(1);
+    }
+  iface.broadcast=0;
+  iface.timeout=1000000;
+
+  samples=(uint64_t *)malloc(count*sizeof(uint64_t));
+  if (samples==NULL)
+    exit(1);
+
+  if (strcmp(format, "csv")==0)
+    printf("command,calls,errors,p50_us,p95_us,p99_us,mean_us,calls_per_sec,syscalls_per_call\n");
+  else if (strcmp(format, "json")==0)
+    printf("{\n  \"transport\": \"%s\",\n  \"baud\": %u,\n  \"calls\": %u,\n  \"results\": [\n",
+	   iface.transport->name, (device!=NULL) ? baud : 0, count);
+  else
+    printf("%-32s %6s %6s %10s %10s %10s %12s %9s\n", "command", "calls", "errors",
+	   "p50 us", "p95 us", "p99 us", "calls/s", "syscalls");
+
+  for (cmd=commands; cmd->name!=NULL; cmd++)
+    {
+      if ((filter!=NULL)&&(strstr(cmd->name, filter)==NULL))
+	continue;
+      bench_run(&iface, &camera, cmd, count, samples, &result);
+      bench_print(format, cmd->name, &result, first);
+      fflush(stdout);
+      first=0;
+    }
+
+  if (strcmp(format, "json")==0)
+    printf("\n  ]\n}\n");
+
+  free(samples);
+  VISCA_close_serial(&iface);
+  if (use_sim)
+    VISCA_sim_destroy(&sim);
+
+  return 0;
+}
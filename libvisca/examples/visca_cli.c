@@ -368,14 +368,18 @@ char *ttydev = "COM1:";
  char *ttydev = "/dev/ttyS0";
 #endif
 
+/*The baud rate of the serial line*/
+uint32_t baud = 9600;
+
 /*Structures needed for the VISCA library*/
 VISCAInterface_t iface;
 VISCACamera_t camera;
 
 /*print usage message and exit*/
 void print_usage() {
-  fprintf(stderr,"Usage: visca-cli [-d <serial port device>] command\n");
+  fprintf(stderr,"Usage: visca-cli [-d <serial port device>] [-b <baud rate>] command\n");
   fprintf(stderr,"  default serial port device: %s\n",ttydev);      
+  fprintf(stderr,"  default baud rate: %u\n",baud);
   fprintf(stderr,"  for available commands see sourcecode...\n");
   exit(1);  
 }
@@ -410,6 +414,19 @@ char *process_commandline(int argc, char **argv) {
       argc -= 2;
     }
   }
+
+  /*Find the baud rate if specified*/
+  if (strncmp(argv[1], "-b", 2) == 0) {
+    /*after the -b and the baud rate at least one command has to follow*/
+    if (argc < 4) {
+      print_usage();
+    } else {
+      baud = strtoul(argv[2], NULL, 10);
+      /*we have used up two arguments*/
+      argv += 2;
+      argc -= 2;
+    }
+  }
   
   /*concatenate command string*/
 
@@ -436,8 +453,8 @@ char *process_commandline(int argc, char **argv) {
 
 void open_interface() {
   int camera_num;
-  if (VISCA_open_serial(&iface, ttydev)!=VISCA_SUCCESS) {
-    fprintf(stderr,"visca-cli: unable to open serial device %s\n",ttydev);
+  if (VISCA_open_serial_ext(&iface, ttydev, baud, VISCA_SERIAL_DEFAULT)!=VISCA_SUCCESS) {
+    fprintf(stderr,"visca-cli: unable to open serial device %s at %u baud\n",ttydev,baud);
     exit(1);
   }
 
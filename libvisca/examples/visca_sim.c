@@ -0,0 +1,91 @@
+/*
+ * VISCA(tm) Camera Simulator
+ * Copyright (C) 2002 Damien Douxchamps 
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Serves a chain of simulated cameras on a pseudo terminal, so that
+ * programs like testvisca and visca_cli can be run without cameras:
+ *
+ *   visca_sim [cameras] &
+ *   testvisca /dev/pts/N
+ *
+ * or as VISCA over IP cameras on a UDP port of the loopback interface
+ * (0: any free one), every -d'th datagram coming in being dropped:
+ *
+ *   visca_sim -u 52381 [-d 10] [cameras] &
+ *   visca_bench -u 127.0.0.1:52381
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "../visca/libvisca.h"
+
+int
+main(int argc, char **argv)
+{
+  VISCASim_t sim;
+  char device_name[64];
+  sigset_t set;
+  uint32_t port, drop=0;
+  int sig, opt, udp=0;
+
+  while ((opt=getopt(argc, argv, "u:d:"))!=-1)
+    switch (opt)
+      {
+      case 'u': udp=1; port=strtoul(optarg, NULL, 10); break;
+      case 'd': drop=strtoul(optarg, NULL, 10); break;
+      default:
+	fprintf(stderr,"Usage: %s [-u <udp port> [-d <drop>]] [cameras]\n",argv[0]);
+	exit(1);
+      }
+
+  VISCA_sim_init(&sim, (optind<argc) ? atoi(argv[optind]) : 1);
+  sim.drop=drop;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  sigprocmask(SIG_BLOCK, &set, NULL);
+
+  if (udp)
+    {
+      if (VISCA_sim_start_udp(&sim, port, &port)!=VISCA_SUCCESS)
+	{
+	  fprintf(stderr,"%s: unable to open the UDP port\n",argv[0]);
+	  exit(1);
+	}
+      snprintf(device_name, sizeof(device_name), "127.0.0.1:%u", port);
+    }
+  else if (VISCA_sim_start_pty(&sim, device_name, sizeof(device_name))!=VISCA_SUCCESS)
+    {
+      fprintf(stderr,"%s: unable to open a pseudo terminal\n",argv[0]);
+      exit(1);
+    }
+
+  printf("%s\n",device_name);
+  fflush(stdout);
+
+  sigwait(&set, &sig);
+
+  VISCA_sim_stop(&sim);
+  VISCA_sim_destroy(&sim);
+
+  return 0;
+}
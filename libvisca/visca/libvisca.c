@@ -19,7 +19,10 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <string.h>
+#include <stdarg.h>
 #include "libvisca.h"
+#include "libvisca_internal.h"
 
 #ifdef WIN
 #include <crtdbg.h>
@@ -46,70 +49,1463 @@
 void
 _VISCA_append_byte(VISCAPacket_t *packet, unsigned char byte)
 {
-  packet->bytes[packet->length]=byte;
-  (packet->length)++;
+  if (packet->length<sizeof(packet->bytes)-1)
+    {
+      packet->bytes[packet->length]=byte;
+      (packet->length)++;
+    }
+}
+
+
+void
+_VISCA_init_packet(VISCAPacket_t *packet)
+{
+  // we start writing at byte 1, the first byte will be filled by the
+  // packet sending function. This function will also append a terminator.
+  packet->length=1;
+}
+
+
+uint32_t
+_VISCA_get_reply(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  uint32_t err;
+
+  // first message: -------------------
+  err=_VISCA_get_packet(iface);
+  if (err!=VISCA_SUCCESS)
+    return err;
+  iface->type=iface->ibuf[1]&0xF0;
+
+  // skip ack messages
+  while (iface->type==VISCA_RESPONSE_ACK)
+    {
+      _VISCA_STAT_ADD(iface->stats.acks_skipped, 1);
+      err=_VISCA_get_packet(iface);
+      if (err!=VISCA_SUCCESS)
+        return err;
+      iface->type=iface->ibuf[1]&0xF0;
+    }
+ 
+  switch (iface->type)
+    {
+    case VISCA_RESPONSE_CLEAR:
+      return VISCA_SUCCESS;
+      break;
+    case VISCA_RESPONSE_ADDRESS:
+      return VISCA_SUCCESS;
+      break;
+    case VISCA_RESPONSE_COMPLETED:
+      return VISCA_SUCCESS;
+      break;
+    case VISCA_RESPONSE_ERROR:
+      return iface->ibuf[2];
+      break;
+    }
+  return VISCA_FAILURE;
+}
+
+#ifndef __AVR__
+
+/* Count the round trip of a finished request in its latency histogram.
+ */
+static void
+_VISCA_stats_latency(VISCAInterface_t *iface, VISCARequest_t *req)
+{
+  uint32_t latency, category, bucket;
+
+  latency=_VISCA_get_time()-req->sent;
+  for (bucket=0; (latency>=2)&&(bucket<VISCA_STATS_BUCKETS-1); bucket++)
+    latency>>=1;
+
+  category=VISCA_STATS_CATEGORY_INDEX(req->packet.bytes[2]);
+  if (req->packet.bytes[1]==VISCA_INQUIRY)
+    _VISCA_STAT_ADD(iface->stats.inquiry_latency[category][bucket], 1);
+  else
+    _VISCA_STAT_ADD(iface->stats.command_latency[category][bucket], 1);
+}
+
+#else
+# define _VISCA_stats_latency(iface, req)
+#endif
+
+static void
+_VISCA_completion_done(VISCAInterface_t *iface, VISCARequest_t *req);
+static void
+_VISCA_drive_done(VISCAInterface_t *iface, VISCARequest_t *req);
+
+/* Route the reply packet in iface->ibuf to the request in flight it
+ * answers. ACKs give their socket to the oldest request of that camera
+ * still waiting for a first reply. Completions and Errors finish the
+ * request holding their socket, or that oldest request for socket 0
+ * (inquiries, refused commands). If the transport tells which packet
+ * the reply answers (iface->reply_tag), only the request sent with it
+ * takes an ACK or a reply of socket 0. The broadcast address reply
+ * finishes the oldest broadcast request. Completions and Errors of a
+ * socket no request holds are dropped, they never finish a request
+ * still waiting for its ACK. Returns the updated request, NULL if the
+ * packet matches none.
+ */
+VISCARequest_t *
+_VISCA_dispatch_reply(VISCAInterface_t *iface)
+{
+  VISCARequest_t **link, **match=NULL, *req;
+  uint32_t address, type, socket;
+
+  _VISCA_STAT_ADD(iface->stats.packets_received, 1);
+  _VISCA_STAT_ADD(iface->stats.bytes_received, iface->bytes);
+
+  if (iface->bytes<3)
+    return NULL;
+
+  address=(iface->ibuf[0]>>4)&0x07;
+  type=iface->ibuf[1]&0xF0;
+  socket=iface->ibuf[1]&0x0F;
+
+  if ((type==VISCA_RESPONSE_ADDRESS)&&(address==0))
+    socket=0;
+  else if ((type!=VISCA_RESPONSE_ACK)&&(type!=VISCA_RESPONSE_COMPLETED)&&(type!=VISCA_RESPONSE_ERROR))
+    return NULL;
+
+  for (link=&iface->requests; *link!=NULL; link=&(*link)->next)
+    {
+      req=*link;
+      if (req->address!=address)
+	continue;
+      if ((type!=VISCA_RESPONSE_ACK)&&(socket!=0))
+	{
+	  if ((req->state==VISCA_REQUEST_ACKED)&&(req->socket==socket))
+	    {
+	      match=link;
+	      break;
+	    }
+	}
+      else if ((req->state==VISCA_REQUEST_SENT)&&
+	       ((iface->reply_tag==0)||(req->tag==iface->reply_tag)))
+	{
+	  match=link;
+	  break;
+	}
+    }
+
+  if (type==VISCA_RESPONSE_ACK)
+    _VISCA_STAT_ADD(iface->stats.acks, 1);
+  else if (type==VISCA_RESPONSE_ERROR)
+    _VISCA_STAT_ADD(iface->stats.errors[VISCA_STATS_ERROR_INDEX(iface->ibuf[2])], 1);
+  else
+    _VISCA_STAT_ADD(iface->stats.completions, 1);
+
+  if (match==NULL)
+    {
+      // e.g. the late Completion of a command given up on
+      if ((type!=VISCA_RESPONSE_ACK)&&(socket!=0))
+	_VISCA_STAT_ADD(iface->stats.stray_replies, 1);
+      return NULL;
+    }
+  req=*match;
+
+  if (type==VISCA_RESPONSE_ACK)
+    {
+      req->state=VISCA_REQUEST_ACKED;
+      req->socket=socket;
+      return req;
+    }
+
+  req->reply.length=(iface->bytes<sizeof(req->reply.bytes)) ? iface->bytes : sizeof(req->reply.bytes);
+  memcpy(req->reply.bytes, iface->ibuf, req->reply.length);
+  if (type==VISCA_RESPONSE_ERROR)
+    {
+      req->error=iface->ibuf[2];
+      req->socket=socket;
+    }
+  else
+    req->error=VISCA_SUCCESS;
+  req->state=VISCA_REQUEST_DONE;
+  *match=req->next;
+  req->next=NULL;
+  _VISCA_stats_latency(iface, req);
+  if (iface->completion!=NULL)
+    _VISCA_completion_done(iface,req);
+  if (req->drive!=NULL)
+    _VISCA_drive_done(iface,req);
+
+  return req;
+}
+
+
+/* Take req out of the requests in flight, if it is there.
+ */
+void
+_VISCA_unlink_request(VISCAInterface_t *iface, VISCARequest_t *req)
+{
+  VISCARequest_t **link;
+
+  for (link=&iface->requests; *link!=NULL; link=&(*link)->next)
+    if (*link==req)
+      {
+	*link=req->next;
+	break;
+      }
+  req->next=NULL;
+}
+
+
+/* Send req->packet and append the request to the ones in flight.
+ * req->packet is left without terminator, so that the request can be
+ * submitted again.
+ */
+uint32_t
+_VISCA_send_request(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req)
+{
+  VISCARequest_t **link;
+  uint32_t err, length;
+
+  req->address=camera->address;
+  req->state=VISCA_REQUEST_SENT;
+  req->socket=0;
+  req->error=VISCA_SUCCESS;
+  req->reply.length=0;
+  req->sent=_VISCA_get_time();
+  req->drive=NULL;
+  req->next=NULL;
+
+  // the header and terminator are written into the packet itself
+  length=req->packet.length;
+  iface->write_tag=0;
+  err=_VISCA_send_packet(iface,camera,&req->packet);
+  req->packet.length=length;
+  if (err!=VISCA_SUCCESS)
+    {
+      req->state=VISCA_REQUEST_DONE;
+      req->error=err;
+      return err;
+    }
+  req->tag=iface->write_tag;
+
+  for (link=&iface->requests; *link!=NULL; link=&(*link)->next);
+  *link=req;
+
+  _VISCA_STAT_ADD(iface->stats.packets_sent, 1);
+  _VISCA_STAT_ADD(iface->stats.bytes_sent, length+1);
+
+  return VISCA_SUCCESS;
+}
+
+
+/* Time left until deadline, the end of a wait of timeout us, to wait
+ * for with _VISCA_wait_reply(): 0 (forever) if timeout is 0. Returns
+ * VISCA_TIMEOUT once the deadline has passed. Replies routed to other
+ * requests meanwhile do not push the deadline back.
+ */
+static uint32_t
+_VISCA_time_left(uint32_t deadline, uint32_t timeout, uint32_t *wait)
+{
+  int32_t left;
+
+  *wait=0;
+  if (timeout==0)
+    return VISCA_SUCCESS;
+
+  left=(int32_t)(deadline-_VISCA_get_time());
+  if (left<=0)
+    return VISCA_TIMEOUT;
+  *wait=(uint32_t)left;
+
+  return VISCA_SUCCESS;
+}
+
+
+/* Wait for replies until req has reached the given state, waiting at
+ * most timeout us (0: forever) in all. If the port fails or times out,
+ * the request is taken out of flight and finished with that error. The
+ * caller holds the interface lock.
+ */
+uint32_t
+_VISCA_wait_request(VISCAInterface_t *iface, VISCARequest_t *req, uint32_t state, uint32_t timeout)
+{
+  uint32_t err, deadline, wait;
+
+  deadline=_VISCA_get_time()+timeout;
+  while (req->state<state)
+    {
+      err=_VISCA_time_left(deadline,timeout,&wait);
+      if (err==VISCA_SUCCESS)
+	err=_VISCA_wait_reply(iface,wait);
+      if ((err!=VISCA_SUCCESS)&&(req->state<state))
+	{
+	  _VISCA_unlink_request(iface,req);
+	  req->state=VISCA_REQUEST_DONE;
+	  req->error=err;
+	  if (err==VISCA_TIMEOUT)
+	    _VISCA_STAT_ADD(iface->stats.timeouts, 1);
+	  return err;
+	}
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+/* Let wait us pass before a retry, routing the replies that come in
+ * meanwhile. The caller holds the interface lock.
+ */
+static void
+_VISCA_backoff(VISCAInterface_t *iface, uint32_t wait)
+{
+  uint32_t deadline, left;
+
+  if (wait==0)
+    return;
+
+  deadline=_VISCA_get_time()+wait;
+  while (_VISCA_time_left(deadline,wait,&left)==VISCA_SUCCESS)
+    if (_VISCA_wait_reply(iface,left)!=VISCA_SUCCESS)
+      break;
+}
+
+
+/* Send req->packet and wait at most timeout us (0: forever) for each
+ * reply packet until its final reply. Commands refused because the
+ * camera's buffer is full are sent again as set by iface->retry_max and
+ * iface->retry_backoff. Returns the port error; the result of the
+ * request itself is left in req->error. The caller holds the interface
+ * lock.
+ */
+static uint32_t
+_VISCA_exchange(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req, uint32_t timeout)
+{
+  VISCAPacket_t packet=req->packet;
+  uint32_t err, tries, wait;
+
+  wait=iface->retry_backoff;
+  for (tries=0;;tries++)
+    {
+      req->packet=packet;
+      err=_VISCA_send_request(iface,camera,req);
+      if (err!=VISCA_SUCCESS)
+	return err;
+
+      err=_VISCA_wait_request(iface,req,VISCA_REQUEST_DONE,timeout);
+      if ((err!=VISCA_SUCCESS)||(req->error!=VISCA_ERROR_CMD_BUFFER_FULL)||
+	  (tries>=iface->retry_max))
+	break;
+
+      _VISCA_STAT_ADD(iface->stats.retries, 1);
+      _VISCA_backoff(iface,wait);
+      if (wait<0x80000000)
+	wait*=2;
+    }
+  if (err==VISCA_SUCCESS)
+    iface->type=req->reply.bytes[1]&0xF0;
+
+  return err;
+}
+
+
+/* Commands starting a movement, whose inquiry returns the current
+ * position rather than the value they were given.
+ */
+static const unsigned char _VISCA_cache_moving[][2] = {
+  { VISCA_CATEGORY_CAMERA1, VISCA_ZOOM_VALUE },
+  { VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_VALUE },
+};
+
+
+static uint32_t
+_VISCA_cache_match(VISCACacheEntry_t *entry, uint32_t address, VISCAPacket_t *inquiry)
+{
+  return ((entry->address==address)&&(entry->inquiry.length==inquiry->length)&&
+	  (memcmp(&entry->inquiry.bytes[1],&inquiry->bytes[1],inquiry->length-1)==0));
+}
+
+
+static uint32_t
+_VISCA_cache_ttl(VISCACache_t *cache, VISCAPacket_t *inquiry)
+{
+  uint32_t i;
+
+  for (i=0;i<cache->fields;i++)
+    if ((cache->field[i].category==inquiry->bytes[2])&&
+	(cache->field[i].command==inquiry->bytes[3]))
+      return cache->field[i].ttl;
+
+  return cache->ttl;
+}
+
+
+/* Find the entry of the inquiry, or take the emptiest one for it: an
+ * empty entry, else the oldest value. Returns NULL if every entry has an
+ * inquiry in flight.
+ */
+static VISCACacheEntry_t *
+_VISCA_cache_entry(VISCACache_t *cache, uint32_t address, VISCAPacket_t *inquiry, uint32_t create)
+{
+  VISCACacheEntry_t *entry, *slot=NULL;
+  uint32_t i, now, age=0;
+
+  now=_VISCA_get_time();
+  for (i=0;i<VISCA_CACHE_ENTRIES;i++)
+    {
+      entry=&cache->entry[i];
+      if (entry->state==VISCA_CACHE_EMPTY)
+	{
+	  if ((slot==NULL)||(slot->state!=VISCA_CACHE_EMPTY))
+	    {
+	      slot=entry;
+	      age=0;
+	    }
+	  continue;
+	}
+      if (_VISCA_cache_match(entry,address,inquiry))
+	return entry;
+      if ((entry->state==VISCA_CACHE_VALID)&&
+	  ((slot==NULL)||((slot->state==VISCA_CACHE_VALID)&&(now-entry->time>age))))
+	{
+	  slot=entry;
+	  age=now-entry->time;
+	}
+    }
+
+  if ((!create)||(slot==NULL))
+    return NULL;
+
+  slot->state=VISCA_CACHE_EMPTY;
+  slot->address=address;
+  slot->inquiry=*inquiry;
+
+  return slot;
+}
+
+
+/* After a successful command, drop the values of its category and the
+ * block inquiries, as the command may change any of them. The value it sets directly is kept
+ * when its inquiry has the same bytes and the reply the same length.
+ */
+static void
+_VISCA_cache_command(VISCACache_t *cache, uint32_t address, VISCAPacket_t *command)
+{
+  VISCACacheEntry_t *entry, *set=NULL;
+  uint32_t i, args;
+
+  args=command->length-4;
+  for (i=0;i<sizeof(_VISCA_cache_moving)/sizeof(_VISCA_cache_moving[0]);i++)
+    if ((_VISCA_cache_moving[i][0]==command->bytes[2])&&
+	(_VISCA_cache_moving[i][1]==command->bytes[3]))
+      args=0;
+
+  for (i=0;i<VISCA_CACHE_ENTRIES;i++)
+    {
+      entry=&cache->entry[i];
+      if ((entry->state!=VISCA_CACHE_VALID)||(entry->address!=address)||
+	  ((entry->inquiry.bytes[2]!=command->bytes[2])&&
+	   (entry->inquiry.bytes[2]!=VISCA_BLOCK_INQUIRY)))
+	continue;
+      if ((args>0)&&(entry->inquiry.length==4)&&
+	  (entry->inquiry.bytes[3]==command->bytes[3])&&(entry->reply.length==args+3))
+	set=entry;
+      entry->state=VISCA_CACHE_EMPTY;
+    }
+
+  if (set!=NULL)
+    {
+      memcpy(&set->reply.bytes[2],&command->bytes[4],args);
+      set->time=_VISCA_get_time();
+      set->state=VISCA_CACHE_VALID;
+    }
+}
+
+
+/* Same as _VISCA_exchange(), going through iface->cache. An inquiry
+ * identical to one in flight waits for the reply to that one instead of
+ * being sent. The caller holds the interface lock.
+ */
+static uint32_t
+_VISCA_cache_exchange(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req, uint32_t timeout)
+{
+  VISCACache_t *cache=iface->cache;
+  VISCACacheEntry_t *entry;
+  VISCAPacket_t packet=req->packet;
+  uint32_t err, ttl, deadline, wait;
+
+  if (packet.bytes[1]!=VISCA_INQUIRY)
+    {
+      err=_VISCA_exchange(iface,camera,req,timeout);
+      if ((err==VISCA_SUCCESS)&&(req->error==VISCA_SUCCESS)&&(packet.bytes[1]==VISCA_COMMAND))
+	_VISCA_cache_command(cache,camera->address,&packet);
+      return err;
+    }
+
+  ttl=_VISCA_cache_ttl(cache,&packet);
+  entry=_VISCA_cache_entry(cache,camera->address,&packet,0);
+
+  if ((entry!=NULL)&&(entry->state==VISCA_CACHE_VALID)&&
+      (_VISCA_get_time()-entry->time<ttl))
+    {
+      cache->hits++;
+      req->reply=entry->reply;
+      req->state=VISCA_REQUEST_DONE;
+      req->socket=0;
+      req->error=VISCA_SUCCESS;
+      iface->type=req->reply.bytes[1]&0xF0;
+      return VISCA_SUCCESS;
+    }
+
+  if ((entry!=NULL)&&(entry->state==VISCA_CACHE_PENDING))
+    {
+      // the request in flight lives until its sender has taken the
+      // lock to fill in the entry
+      deadline=_VISCA_get_time()+timeout;
+      while ((entry->state==VISCA_CACHE_PENDING)&&_VISCA_cache_match(entry,camera->address,&packet)&&
+	     (entry->request->state!=VISCA_REQUEST_DONE))
+	{
+	  err=_VISCA_time_left(deadline,timeout,&wait);
+	  if (err==VISCA_SUCCESS)
+	    err=_VISCA_wait_reply(iface,wait);
+	  if (err!=VISCA_SUCCESS)
+	    {
+	      req->state=VISCA_REQUEST_DONE;
+	      req->socket=0;
+	      req->error=err;
+	      if (err==VISCA_TIMEOUT)
+		_VISCA_STAT_ADD(iface->stats.timeouts, 1);
+	      return err;
+	    }
+	}
+      if ((entry->state==VISCA_CACHE_PENDING)&&_VISCA_cache_match(entry,camera->address,&packet))
+	{
+	  req->reply=entry->request->reply;
+	  req->socket=entry->request->socket;
+	  req->error=entry->request->error;
+	  req->state=VISCA_REQUEST_DONE;
+	  cache->merged++;
+	  iface->type=req->reply.bytes[1]&0xF0;
+	  return VISCA_SUCCESS;
+	}
+      if ((entry->state==VISCA_CACHE_VALID)&&_VISCA_cache_match(entry,camera->address,&packet))
+	{
+	  req->reply=entry->reply;
+	  req->socket=0;
+	  req->error=VISCA_SUCCESS;
+	  req->state=VISCA_REQUEST_DONE;
+	  cache->merged++;
+	  iface->type=req->reply.bytes[1]&0xF0;
+	  return VISCA_SUCCESS;
+	}
+      // the inquiry failed, or its entry was taken over: send it again
+    }
+
+  cache->misses++;
+  entry=_VISCA_cache_entry(cache,camera->address,&packet,1);
+  if (entry!=NULL)
+    {
+      entry->state=VISCA_CACHE_PENDING;
+      entry->request=req;
+    }
+
+  err=_VISCA_exchange(iface,camera,req,timeout);
+
+  if (entry!=NULL)
+    {
+      entry->request=NULL;
+      // kept even with a ttl of 0, for the inquiries merged into this one
+      if ((err==VISCA_SUCCESS)&&(req->error==VISCA_SUCCESS))
+	{
+	  entry->reply=req->reply;
+	  entry->time=_VISCA_get_time();
+	  entry->state=VISCA_CACHE_VALID;
+	}
+      else
+	entry->state=VISCA_CACHE_EMPTY;
+    }
+
+  return err;
+}
+
+
+/* Commands sent under a completion policy other than
+ * VISCA_COMPLETION_WAIT run in the requests of iface->completion until
+ * their final reply. A request is free once done and no caller waits on
+ * it any more.
+ */
+static int
+_VISCA_completion_index(VISCACompletion_t *completion, VISCARequest_t *req)
+{
+  if ((req<completion->request)||(req>=completion->request+VISCA_COMPLETION_REQUESTS))
+    return -1;
+
+  return (int)(req-completion->request);
+}
+
+
+/* Report the final reply of a command running in iface->completion. The
+ * caller holds the interface lock.
+ */
+static void
+_VISCA_completion_done(VISCAInterface_t *iface, VISCARequest_t *req)
+{
+  VISCACompletion_t *completion=iface->completion;
+  VISCAResult_t *result, callback_result;
+
+  if (_VISCA_completion_index(completion,req)<0)
+    return;
+
+  if ((req->error==VISCA_SUCCESS)&&(iface->cache!=NULL))
+    _VISCA_cache_command(iface->cache,req->address,&req->packet);
+
+  if (completion->callback!=NULL)
+    result=&callback_result;
+  else
+    {
+      if (completion->results==VISCA_COMPLETION_RESULTS)
+	{
+	  completion->head=(completion->head+1)%VISCA_COMPLETION_RESULTS;
+	  completion->results--;
+	  completion->lost++;
+	}
+      result=&completion->result[(completion->head+completion->results)%VISCA_COMPLETION_RESULTS];
+      completion->results++;
+    }
+
+  result->address=req->address;
+  result->error=req->error;
+  result->socket=req->socket;
+  result->command=req->packet;
+
+  if (completion->callback!=NULL)
+    completion->callback(completion,result,completion->data);
+}
+
+
+/* Finish the commands of iface->completion left unanswered for
+ * iface->timeout with VISCA_TIMEOUT. The caller holds the interface lock.
+ */
+static void
+_VISCA_completion_expire(VISCAInterface_t *iface)
+{
+  VISCACompletion_t *completion=iface->completion;
+  VISCARequest_t *req;
+  uint32_t i, now;
+
+  if (iface->timeout==0)
+    return;
+
+  now=_VISCA_get_time();
+  for (i=0;i<VISCA_COMPLETION_REQUESTS;i++)
+    {
+      req=&completion->request[i];
+      if ((req->state==VISCA_REQUEST_DONE)||completion->held[i]||
+	  (now-req->sent<iface->timeout))
+	continue;
+      _VISCA_unlink_request(iface,req);
+      req->state=VISCA_REQUEST_DONE;
+      req->error=VISCA_TIMEOUT;
+      _VISCA_STAT_ADD(iface->stats.timeouts, 1);
+      _VISCA_completion_done(iface,req);
+    }
+}
+
+
+/* Take a free request of iface->completion, routing replies for at most
+ * timeout us in all (0: forever) until a command in flight finishes if
+ * there is none. The caller holds the interface lock.
+ */
+static uint32_t
+_VISCA_completion_request(VISCAInterface_t *iface, uint32_t timeout, VISCARequest_t **req)
+{
+  VISCACompletion_t *completion=iface->completion;
+  uint32_t i, err, deadline, wait;
+
+  deadline=_VISCA_get_time()+timeout;
+  for (;;)
+    {
+      _VISCA_completion_expire(iface);
+      for (i=0;i<VISCA_COMPLETION_REQUESTS;i++)
+	if ((completion->request[i].state==VISCA_REQUEST_DONE)&&!completion->held[i])
+	  {
+	    *req=&completion->request[i];
+	    return VISCA_SUCCESS;
+	  }
+
+      err=_VISCA_time_left(deadline,timeout,&wait);
+      if (err!=VISCA_SUCCESS)
+	return err;
+      err=_VISCA_wait_reply(iface,wait);
+      if ((err!=VISCA_SUCCESS)&&(err!=VISCA_TIMEOUT))
+	return err;
+    }
+}
+
+
+/* Same as _VISCA_exchange() for a command, but returning as set by the
+ * policy of iface->completion: once sent, or once acknowledged. The
+ * command then keeps running in a request of iface->completion, and
+ * status only tells how far it got. The caller holds the interface lock.
+ */
+static uint32_t
+_VISCA_completion_send(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *status, uint32_t timeout)
+{
+  VISCACompletion_t *completion=iface->completion;
+  VISCARequest_t *req;
+  uint32_t err;
+  int i;
+
+  status->state=VISCA_REQUEST_DONE;
+  status->socket=0;
+  status->reply.length=0;
+
+  err=_VISCA_completion_request(iface,timeout,&req);
+  if (err!=VISCA_SUCCESS)
+    {
+      status->error=err;
+      return err;
+    }
+  i=_VISCA_completion_index(completion,req);
+
+  req->packet=status->packet;
+  err=_VISCA_send_request(iface,camera,req);
+  if (err!=VISCA_SUCCESS)
+    {
+      status->error=err;
+      return err;
+    }
+
+  if (completion->policy==VISCA_COMPLETION_ACK)
+    {
+      completion->held[i]=1;
+      err=_VISCA_wait_request(iface,req,VISCA_REQUEST_ACKED,timeout);
+      completion->held[i]=0;
+      // the command was sent, so a lost ACK is reported like a lost Completion
+      if (err!=VISCA_SUCCESS)
+	_VISCA_completion_done(iface,req);
+    }
+
+  status->state=req->state;
+  status->socket=req->socket;
+  status->error=(req->state==VISCA_REQUEST_DONE) ? req->error : VISCA_SUCCESS;
+  if (req->state==VISCA_REQUEST_DONE)
+    status->reply=req->reply;
+
+  return err;
+}
+
+
+/* Send req->packet as set by the interface, caching and completion
+ * policy, waiting at most timeout us (0: forever) for each time it is sent.
+ * The error of an Error reply is kept in camera->last_error with its
+ * socket. Returns the port or timeout error, the result of the request
+ * is in req.
+ */
+static uint32_t
+_VISCA_request_with_reply(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req, uint32_t timeout)
+{
+  uint32_t err;
+
+  _VISCA_lock(iface);
+  if ((iface->completion!=NULL)&&(iface->completion->policy!=VISCA_COMPLETION_WAIT)&&
+      (iface->broadcast==0)&&(req->packet.bytes[1]==VISCA_COMMAND))
+    err=_VISCA_completion_send(iface,camera,req,timeout);
+  else if ((iface->cache!=NULL)&&(iface->broadcast==0))
+    err=_VISCA_cache_exchange(iface,camera,req,timeout);
+  else
+    err=_VISCA_exchange(iface,camera,req,timeout);
+  _VISCA_unlock(iface);
+
+  camera->last_error=req->error;
+  camera->last_socket=req->socket;
+
+  return err;
+}
+
+
+uint32_t
+_VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet)
+{
+  return _VISCA_send_packet_with_reply_timeout(iface,camera,packet,iface->timeout);
+}
+
+/* Same as above, but waits at most timeout us (0: forever) for the reply
+ * instead of iface->timeout. The reply is returned in packet, which
+ * the caller owns, so concurrent calls do not overwrite each other's
+ * replies. An Error reply is returned in packet as well, and its error
+ * code is returned, and kept in camera->last_error with its socket.
+ * Commands refused because the camera's buffer is full are sent again
+ * as set by iface->retry_max and iface->retry_backoff.
+ */
+uint32_t
+_VISCA_send_packet_with_reply_timeout(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet, uint32_t timeout)
+{
+  VISCARequest_t req;
+  uint32_t err;
+
+  req.packet=*packet;
+  err=_VISCA_request_with_reply(iface,camera,&req,timeout);
+  if (err!=VISCA_SUCCESS)
+    return err;
+
+  // a command still running leaves the packet as it was
+  if (req.state==VISCA_REQUEST_DONE)
+    *packet=req.reply;
+
+  return req.error;
+}
+
+
+/****************************************************************************/
+/*                           PUBLIC FUNCTIONS                               */
+/****************************************************************************/
+
+
+#ifndef __AVR__
+
+/***********************************/
+/*          STATISTICS             */
+/***********************************/
+
+uint32_t
+VISCA_get_stats(VISCAInterface_t *iface, VISCAStats_t *stats)
+{
+  uint32_t *src=(uint32_t *)&iface->stats;
+  uint32_t *dst=(uint32_t *)stats;
+  uint32_t i;
+
+  for (i=0; i<sizeof(VISCAStats_t)/sizeof(uint32_t); i++)
+    dst[i]=_VISCA_STAT_GET(src[i]);
+
+  return VISCA_SUCCESS;
+}
+
+#endif
+
+
+/***********************************/
+/*      ASYNCHRONOUS COMMANDS      */
+/***********************************/
+
+uint32_t
+VISCA_command_submit(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req)
+{
+  uint32_t err;
+
+  _VISCA_lock(iface);
+  err=_VISCA_send_request(iface,camera,req);
+  if (err==VISCA_SUCCESS)
+    err=_VISCA_wait_request(iface,req,VISCA_REQUEST_ACKED,iface->timeout);
+  _VISCA_unlock(iface);
+
+  if (err!=VISCA_SUCCESS)
+    return err;
+
+  if (req->state==VISCA_REQUEST_DONE)
+    return req->error;
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_command_wait(VISCAInterface_t *iface, VISCARequest_t *req)
+{
+  uint32_t err;
+
+  _VISCA_lock(iface);
+  err=_VISCA_wait_request(iface,req,VISCA_REQUEST_DONE,iface->timeout);
+  _VISCA_unlock(iface);
+
+  if (err!=VISCA_SUCCESS)
+    return err;
+
+  return req->error;
+}
+
+
+
+/***********************************/
+/*        MULTI-CAMERA BUS         */
+/***********************************/
+
+/* Send queued requests while their camera's window has room. Requests in
+ * flight are counted on the interface, so requests finished by the reader
+ * thread or by other callers are accounted for as well. Requests that
+ * could not be sent are done with the port error, and put in *failed if
+ * failed is not NULL.
+ */
+void
+_VISCA_bus_start(VISCABus_t *bus, VISCARequest_t **failed)
+{
+  VISCACamera_t camera; /* dummy camera struct */
+  VISCARequest_t *req;
+  uint32_t inflight[8];
+  uint32_t address;
+
+  for (address=0;address<8;address++)
+    inflight[address]=0;
+  for (req=bus->iface->requests; req!=NULL; req=req->next)
+    inflight[req->address&0x07]++;
+
+  for (address=1;address<8;address++)
+    while ((bus->queue[address]!=NULL)&&(inflight[address]<bus->window))
+      {
+	req=bus->queue[address];
+	bus->queue[address]=req->next;
+	camera.address=address;
+	if (_VISCA_send_request(bus->iface,&camera,req)==VISCA_SUCCESS)
+	  inflight[address]++;
+	else if (failed!=NULL)
+	  {
+	    req->next=*failed;
+	    *failed=req;
+	  }
+      }
+}
+
+
+void
+VISCA_bus_init(VISCABus_t *bus, VISCAInterface_t *iface)
+{
+  int i;
+
+  bus->iface=iface;
+  bus->window=1;
+  for (i=0;i<8;i++)
+    bus->queue[i]=NULL;
+}
+
+
+uint32_t
+VISCA_bus_submit(VISCABus_t *bus, VISCACamera_t *camera, VISCARequest_t *req)
+{
+  VISCARequest_t **link;
+
+  if ((camera->address<1)||(camera->address>7))
+    return VISCA_FAILURE;
+
+  req->address=camera->address;
+  req->state=VISCA_REQUEST_QUEUED;
+  req->callback=NULL;
+  req->next=NULL;
+
+  _VISCA_lock(bus->iface);
+  for (link=&bus->queue[req->address]; *link!=NULL; link=&(*link)->next);
+  *link=req;
+  _VISCA_bus_start(bus,NULL);
+  _VISCA_unlock(bus->iface);
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_bus_process(VISCABus_t *bus)
+{
+  VISCAInterface_t *iface=bus->iface;
+  VISCARequest_t *req, *next;
+  uint32_t now, age, wait, err;
+
+  _VISCA_lock(iface);
+  if (iface->requests==NULL)
+    {
+      // the reader thread may have finished them all meanwhile
+      _VISCA_bus_start(bus,NULL);
+      _VISCA_unlock(iface);
+      return VISCA_SUCCESS;
+    }
+
+  // wait until the oldest request in flight runs out of time
+  wait=0;
+  if (iface->timeout>0)
+    {
+      now=_VISCA_get_time();
+      wait=iface->timeout;
+      for (req=iface->requests; req!=NULL; req=req->next)
+	{
+	  age=now-req->sent;
+	  if (age>=iface->timeout)
+	    wait=1;
+	  else if (iface->timeout-age<wait)
+	    wait=iface->timeout-age;
+	}
+    }
+
+  err=_VISCA_wait_reply(iface,wait);
+  if ((err!=VISCA_SUCCESS)&&(err!=VISCA_TIMEOUT))
+    {
+      _VISCA_unlock(iface);
+      return err;
+    }
+
+  // give up on the requests that are out of time
+  now=_VISCA_get_time();
+  for (req=iface->requests; req!=NULL; req=next)
+    {
+      next=req->next;
+      if ((iface->timeout>0)&&(now-req->sent>=iface->timeout))
+	{
+	  _VISCA_unlink_request(iface,req);
+	  req->state=VISCA_REQUEST_DONE;
+	  req->error=VISCA_TIMEOUT;
+	  _VISCA_STAT_ADD(iface->stats.timeouts, 1);
+	}
+    }
+
+  _VISCA_bus_start(bus,NULL);
+  _VISCA_unlock(iface);
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_bus_wait(VISCABus_t *bus, VISCARequest_t *req)
+{
+  VISCAInterface_t *iface=bus->iface;
+  uint32_t err, state, lost;
+
+  for (;;)
+    {
+      // the reader thread finishes requests under the lock
+      _VISCA_lock(iface);
+      state=req->state;
+      lost=(iface->requests==NULL)&&(state!=VISCA_REQUEST_QUEUED);
+      _VISCA_unlock(iface);
+
+      if (state==VISCA_REQUEST_DONE)
+	break;
+      if (lost)
+	return VISCA_FAILURE;
+      err=VISCA_bus_process(bus);
+      if (err!=VISCA_SUCCESS)
+	return err;
+    }
+
+  return req->error;
+}
+
+
+uint32_t
+VISCA_bus_flush(VISCABus_t *bus)
+{
+  VISCAInterface_t *iface=bus->iface;
+  uint32_t err, busy;
+
+  do
+    {
+      err=VISCA_bus_process(bus);
+      if (err!=VISCA_SUCCESS)
+	return err;
+
+      _VISCA_lock(iface);
+      busy=(iface->requests!=NULL);
+      _VISCA_unlock(iface);
+    }
+  while (busy);
+
+  return VISCA_SUCCESS;
+}
+
+
+/***********************************/
+/*            BATCHES              */
+/***********************************/
+
+void
+VISCA_batch_init(VISCABatch_t *batch, VISCAInterface_t *iface)
+{
+  VISCA_bus_init(&batch->bus, iface);
+  batch->bus.window=2;
+  batch->count=0;
+}
+
+
+uint32_t
+VISCA_batch_add(VISCABatch_t *batch, VISCACamera_t *camera, VISCAPacket_t *packet)
+{
+  if (batch->count>=VISCA_BATCH_SIZE)
+    return VISCA_FAILURE;
+
+  batch->camera[batch->count]=camera;
+  batch->request[batch->count].packet=*packet;
+  batch->count++;
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_batch_run(VISCABatch_t *batch)
+{
+  VISCAInterface_t *iface=batch->bus.iface;
+  VISCARequest_t *req;
+  uint32_t i, err, first;
+
+  for (i=0;i<batch->count;i++)
+    {
+      req=&batch->request[i];
+      req->state=VISCA_REQUEST_DONE;
+      req->error=VISCA_FAILURE;
+      VISCA_bus_submit(&batch->bus,batch->camera[i],req);
+    }
+
+  err=VISCA_bus_flush(&batch->bus);
+
+  // on a port failure, take the unfinished commands back
+  _VISCA_lock(iface);
+  for (i=0;i<batch->count;i++)
+    {
+      req=&batch->request[i];
+      if (req->state!=VISCA_REQUEST_DONE)
+	{
+	  _VISCA_unlink_request(iface,req);
+	  req->state=VISCA_REQUEST_DONE;
+	  req->error=err;
+	}
+    }
+  for (i=0;i<8;i++)
+    batch->bus.queue[i]=NULL;
+  _VISCA_unlock(iface);
+
+  first=VISCA_SUCCESS;
+  for (i=0;i<batch->count;i++)
+    {
+      batch->result[i]=batch->request[i].error;
+      if ((first==VISCA_SUCCESS)&&(batch->result[i]!=VISCA_SUCCESS))
+	first=batch->result[i];
+    }
+
+  return first;
+}
+
+
+/***********************************/
+/*          STATE CACHE            */
+/***********************************/
+
+void
+VISCA_cache_init(VISCACache_t *cache, uint32_t ttl)
+{
+  int i;
+
+  cache->ttl=ttl;
+  cache->fields=0;
+  for (i=0;i<VISCA_CACHE_ENTRIES;i++)
+    {
+      cache->entry[i].state=VISCA_CACHE_EMPTY;
+      cache->entry[i].request=NULL;
+    }
+  cache->hits=0;
+  cache->misses=0;
+  cache->merged=0;
+}
+
+
+uint32_t
+VISCA_cache_set_ttl(VISCACache_t *cache, uint32_t category, uint32_t command, uint32_t ttl)
+{
+  uint32_t i;
+
+  for (i=0;i<cache->fields;i++)
+    if ((cache->field[i].category==category)&&(cache->field[i].command==command))
+      break;
+
+  if (i>=VISCA_CACHE_FIELDS)
+    return VISCA_FAILURE;
+
+  cache->field[i].category=category;
+  cache->field[i].command=command;
+  cache->field[i].ttl=ttl;
+  if (i==cache->fields)
+    cache->fields++;
+
+  return VISCA_SUCCESS;
 }
 
 
 void
-_VISCA_init_packet(VISCAPacket_t *packet)
+VISCA_cache_invalidate(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  // we start writing at byte 1, the first byte will be filled by the
-  // packet sending function. This function will also append a terminator.
-  packet->length=1;
+  VISCACacheEntry_t *entry;
+  int i;
+
+  _VISCA_lock(iface);
+  for (i=0;i<VISCA_CACHE_ENTRIES;i++)
+    {
+      entry=&iface->cache->entry[i];
+      if ((entry->state==VISCA_CACHE_VALID)&&(entry->address==camera->address))
+	entry->state=VISCA_CACHE_EMPTY;
+    }
+  _VISCA_unlock(iface);
+}
+
+
+/***********************************/
+/*       COMPLETION POLICY         */
+/***********************************/
+
+void
+VISCA_completion_init(VISCACompletion_t *completion, uint32_t policy, VISCACompletionCallback_t callback, void *data)
+{
+  int i;
+
+  completion->policy=policy;
+  completion->callback=callback;
+  completion->data=data;
+
+  for (i=0;i<VISCA_COMPLETION_REQUESTS;i++)
+    {
+      completion->request[i].state=VISCA_REQUEST_DONE;
+      completion->request[i].next=NULL;
+      completion->held[i]=0;
+    }
+
+  completion->head=0;
+  completion->results=0;
+  completion->lost=0;
 }
 
 
 uint32_t
-_VISCA_get_reply(VISCAInterface_t *iface, VISCACamera_t *camera)
+VISCA_completion_get(VISCAInterface_t *iface, VISCAResult_t *result, uint32_t timeout)
 {
-  // first message: -------------------
-  if ( !(_VISCA_get_packet(iface)!=VISCA_SUCCESS) ) 
+  VISCACompletion_t *completion=iface->completion;
+  uint32_t err=VISCA_SUCCESS, start, elapsed, wait, busy, i;
+
+  if (completion==NULL)
     return VISCA_FAILURE;
-  iface->type=iface->ibuf[1]&0xF0;
 
-  // skip ack messages
-  while (iface->type==VISCA_RESPONSE_ACK)
+  _VISCA_lock(iface);
+  start=_VISCA_get_time();
+  for (;;)
     {
-      if ( !(_VISCA_get_packet(iface)!=VISCA_SUCCESS) ) 
-        return VISCA_FAILURE;
-      iface->type=iface->ibuf[1]&0xF0;
+      _VISCA_completion_expire(iface);
+      if (completion->results>0)
+	break;
+
+      busy=0;
+      for (i=0;i<VISCA_COMPLETION_REQUESTS;i++)
+	if (completion->request[i].state!=VISCA_REQUEST_DONE)
+	  busy=1;
+      if (!busy)
+	{
+	  err=VISCA_FAILURE;
+	  break;
+	}
+
+      // wake up in time to expire unanswered commands
+      wait=timeout;
+      if (timeout!=0)
+	{
+	  elapsed=_VISCA_get_time()-start;
+	  if (elapsed>=timeout)
+	    {
+	      err=VISCA_TIMEOUT;
+	      break;
+	    }
+	  wait=timeout-elapsed;
+	}
+      if ((iface->timeout!=0)&&((wait==0)||(wait>iface->timeout)))
+	wait=iface->timeout;
+
+      err=_VISCA_wait_reply(iface,wait);
+      if ((err!=VISCA_SUCCESS)&&(err!=VISCA_TIMEOUT))
+	break;
+      err=VISCA_SUCCESS;
     }
- 
-  switch (iface->type)
+
+  if (completion->results>0)
     {
-    case VISCA_RESPONSE_CLEAR:
-      return VISCA_SUCCESS;
-      break;
-    case VISCA_RESPONSE_ADDRESS:
-      return VISCA_SUCCESS;
-      break;
-    case VISCA_RESPONSE_COMPLETED:
-      return VISCA_SUCCESS;
-      break;
-    case VISCA_RESPONSE_ERROR:
+      *result=completion->result[completion->head];
+      completion->head=(completion->head+1)%VISCA_COMPLETION_RESULTS;
+      completion->results--;
+      err=VISCA_SUCCESS;
+    }
+  _VISCA_unlock(iface);
+
+  return err;
+}
+
+
+/***********************************/
+/*        COALESCED DRIVE          */
+/***********************************/
+
+/* Send packet as the drive command of the given channel. The caller
+ * holds the interface lock.
+ */
+static void
+_VISCA_drive_send(VISCADrive_t *drive, uint32_t channel, VISCAPacket_t *packet)
+{
+  VISCARequest_t *req=&drive->request[channel];
+
+  req->packet=*packet;
+  drive->error[channel]=_VISCA_send_request(drive->iface,drive->camera,req);
+  req->drive=drive;
+  drive->sent++;
+}
+
+
+/* A drive command has finished: send the newest vector left on its
+ * channel meanwhile. Called from the reply path, the caller holds the
+ * interface lock.
+ */
+static void
+_VISCA_drive_done(VISCAInterface_t *iface, VISCARequest_t *req)
+{
+  VISCADrive_t *drive=req->drive;
+  uint32_t channel=(uint32_t)(req-drive->request);
+
+  drive->error[channel]=req->error;
+  if ((req->error==VISCA_SUCCESS)&&(iface->cache!=NULL))
+    _VISCA_cache_command(iface->cache,req->address,&req->packet);
+
+  if (drive->pending[channel])
+    {
+      drive->pending[channel]=0;
+      _VISCA_drive_send(drive,channel,&drive->next[channel]);
+    }
+}
+
+
+/* Send the drive command in packet on the given channel, or leave it to
+ * the reply path if a drive command is in flight there.
+ */
+static uint32_t
+_VISCA_drive(VISCADrive_t *drive, uint32_t channel, VISCAPacket_t *packet)
+{
+  VISCAInterface_t *iface=drive->iface;
+  VISCARequest_t *req=&drive->request[channel];
+  uint32_t err;
+
+  _VISCA_lock(iface);
+
+  // a command left unanswered does not hold the channel forever
+  if ((req->state!=VISCA_REQUEST_DONE)&&(iface->timeout>0)&&
+      (_VISCA_get_time()-req->sent>=iface->timeout))
+    {
+      _VISCA_unlink_request(iface,req);
+      req->state=VISCA_REQUEST_DONE;
+      req->error=VISCA_TIMEOUT;
+      drive->error[channel]=VISCA_TIMEOUT;
+      _VISCA_STAT_ADD(iface->stats.timeouts, 1);
+    }
+
+  if (drive->pending[channel])
+    {
+      drive->pending[channel]=0;
+      drive->dropped++;
+    }
+
+  if (req->state!=VISCA_REQUEST_DONE)
+    {
+      drive->next[channel]=*packet;
+      drive->pending[channel]=1;
+      _VISCA_unlock(iface);
       return VISCA_SUCCESS;
-      break;
     }
-  return VISCA_FAILURE;
+
+  _VISCA_drive_send(drive,channel,packet);
+  err=(req->state==VISCA_REQUEST_DONE) ? req->error : VISCA_SUCCESS;
+  _VISCA_unlock(iface);
+
+  return err;
+}
+
+
+void
+VISCA_drive_init(VISCADrive_t *drive, VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  int i;
+
+  drive->iface=iface;
+  drive->camera=camera;
+  for (i=0;i<2;i++)
+    {
+      drive->request[i].state=VISCA_REQUEST_DONE;
+      drive->request[i].callback=NULL;
+      drive->request[i].drive=NULL;
+      drive->request[i].next=NULL;
+      drive->pending[i]=0;
+      drive->error[i]=VISCA_SUCCESS;
+    }
+  drive->sent=0;
+  drive->dropped=0;
 }
 
+
 uint32_t
-_VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet)
+VISCA_drive_pantilt(VISCADrive_t *drive, int pan_speed, int tilt_speed)
 {
-  if (_VISCA_send_packet(iface,camera,packet)!=VISCA_SUCCESS)
-    return VISCA_FAILURE;
+  VISCAPacket_t packet;
+  unsigned char pan_dir, tilt_dir;
 
-  if (_VISCA_get_reply(iface,camera)!=VISCA_SUCCESS)
-    return VISCA_FAILURE;
+  if (pan_speed>VISCA_PT_DRIVE_PAN_SPEED_MAX)
+    pan_speed=VISCA_PT_DRIVE_PAN_SPEED_MAX;
+  else if (pan_speed<-VISCA_PT_DRIVE_PAN_SPEED_MAX)
+    pan_speed=-VISCA_PT_DRIVE_PAN_SPEED_MAX;
+  if (tilt_speed>VISCA_PT_DRIVE_TILT_SPEED_MAX)
+    tilt_speed=VISCA_PT_DRIVE_TILT_SPEED_MAX;
+  else if (tilt_speed<-VISCA_PT_DRIVE_TILT_SPEED_MAX)
+    tilt_speed=-VISCA_PT_DRIVE_TILT_SPEED_MAX;
+
+  if (pan_speed>0)
+    pan_dir=VISCA_PT_DRIVE_HORIZ_RIGHT;
+  else if (pan_speed<0)
+    {
+      pan_dir=VISCA_PT_DRIVE_HORIZ_LEFT;
+      pan_speed=-pan_speed;
+    }
+  else
+    {
+      pan_dir=VISCA_PT_DRIVE_HORIZ_STOP;
+      pan_speed=1;
+    }
+
+  if (tilt_speed>0)
+    tilt_dir=VISCA_PT_DRIVE_VERT_UP;
+  else if (tilt_speed<0)
+    {
+      tilt_dir=VISCA_PT_DRIVE_VERT_DOWN;
+      tilt_speed=-tilt_speed;
+    }
+  else
+    {
+      tilt_dir=VISCA_PT_DRIVE_VERT_STOP;
+      tilt_speed=1;
+    }
+
+  _VISCA_init_packet(&packet);
+  _VISCA_append_byte(&packet, VISCA_COMMAND);
+  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
+  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
+  _VISCA_append_byte(&packet, pan_speed);
+  _VISCA_append_byte(&packet, tilt_speed);
+  _VISCA_append_byte(&packet, pan_dir);
+  _VISCA_append_byte(&packet, tilt_dir);
 
-  return VISCA_SUCCESS;    
+  return _VISCA_drive(drive, VISCA_DRIVE_PANTILT, &packet);
 }
 
 
-/****************************************************************************/
-/*                           PUBLIC FUNCTIONS                               */
-/****************************************************************************/
+uint32_t
+VISCA_drive_zoom(VISCADrive_t *drive, int speed)
+{
+  VISCAPacket_t packet;
+
+  _VISCA_init_packet(&packet);
+  _VISCA_append_byte(&packet, VISCA_COMMAND);
+  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
+  _VISCA_append_byte(&packet, VISCA_ZOOM);
+  if (speed>VISCA_ZOOM_SPEED_MAX)
+    speed=VISCA_ZOOM_SPEED_MAX;
+  else if (speed<-VISCA_ZOOM_SPEED_MAX)
+    speed=-VISCA_ZOOM_SPEED_MAX;
+  if (speed>0)
+    _VISCA_append_byte(&packet, VISCA_ZOOM_TELE_SPEED | speed);
+  else if (speed<0)
+    _VISCA_append_byte(&packet, VISCA_ZOOM_WIDE_SPEED | -speed);
+  else
+    _VISCA_append_byte(&packet, VISCA_ZOOM_STOP);
+
+  return _VISCA_drive(drive, VISCA_DRIVE_ZOOM, &packet);
+}
 
 
 /***********************************/
@@ -121,6 +1517,7 @@ VISCA_set_address(VISCAInterface_t *iface, int *camera_num)
 {
   VISCAPacket_t packet;
   int backup;
+  uint32_t err;
   VISCACamera_t camera; /* dummy camera struct */
 
   camera.address=0;
@@ -131,28 +1528,23 @@ VISCA_set_address(VISCAInterface_t *iface, int *camera_num)
   _VISCA_append_byte(&packet,0x01);
 
   iface->broadcast=1;
-  if (_VISCA_send_packet(iface, &camera, &packet)!=VISCA_SUCCESS)
-    {
-      iface->broadcast=backup;
-      return VISCA_FAILURE;
-    }
-  else
-    iface->broadcast=backup;
-  
-  if (_VISCA_get_reply(iface, &camera)!=VISCA_SUCCESS)
-    return VISCA_FAILURE;
+  err=_VISCA_send_packet_with_reply(iface, &camera, &packet);
+  iface->broadcast=backup;
+
+  if (err!=VISCA_SUCCESS)
+    return err;
   else
     {
       /* We parse the message from the camera here  */
       /* We expect to receive 4*camera_num bytes,
          every packet should be 88 30 0x FF, x being
          the camera id+1. The number of cams will thus be
-         ibuf[bytes-2]-1  */
-      if ((iface->bytes & 0x3)!=0) /* check multiple of 4 */
+         bytes[length-2]-1  */
+      if ((packet.length & 0x3)!=0) /* check multiple of 4 */
 	return VISCA_FAILURE;
       else
 	{
-	  *camera_num=iface->ibuf[iface->bytes-2]-1;
+	  *camera_num=packet.bytes[packet.length-2]-1;
 	  if ((*camera_num==0)||(*camera_num>7))
 	    return VISCA_FAILURE;
 	  else
@@ -173,44 +1565,243 @@ VISCA_clear(VISCAInterface_t *iface, VISCACamera_t *camera)
   _VISCA_append_byte(&packet,0x00);
   _VISCA_append_byte(&packet,0x01);
 
-  if (_VISCA_send_packet(iface, camera, &packet)!=VISCA_SUCCESS)
-    return VISCA_FAILURE;
-  else
-    if (_VISCA_get_reply(iface, camera)!=VISCA_SUCCESS)
-      return VISCA_FAILURE;
-    else
-      return VISCA_SUCCESS;
+  return _VISCA_send_packet_with_reply(iface, camera, &packet);
 }
 
 uint32_t
 VISCA_get_camera_info(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
   VISCAPacket_t packet;
-  packet.bytes[0]=0x80 | camera->address;
-  packet.bytes[1]=0x09;
-  packet.bytes[2]=0x00;
-  packet.bytes[3]=0x02;
-  packet.bytes[4]=VISCA_TERMINATOR;
-  packet.length=5;
+  uint32_t err;
 
-  if (_VISCA_write_packet_data(iface, camera, &packet)!=VISCA_SUCCESS)
-    return VISCA_FAILURE;
-  else
-    if (_VISCA_get_reply(iface, camera)!=VISCA_SUCCESS)
-      return VISCA_FAILURE;
+  _VISCA_init_packet(&packet);
+  _VISCA_append_byte(&packet, VISCA_INQUIRY);
+  _VISCA_append_byte(&packet, VISCA_CATEGORY_INTERFACE);
+  _VISCA_append_byte(&packet, 0x02);
+
+  err=_VISCA_send_packet_with_reply(iface, camera, &packet);
+  if (err!=VISCA_SUCCESS)
+    return err;
 
-  if (iface->bytes!= 10) /* we expect 10 bytes as answer */
+  if (packet.length!= 10) /* we expect 10 bytes as answer */
     return VISCA_FAILURE;
   else
     {
-      camera->vendor=(iface->ibuf[2]<<8) + iface->ibuf[3];
-      camera->model=(iface->ibuf[4]<<8) + iface->ibuf[5];
-      camera->rom_version=(iface->ibuf[6]<<8) + iface->ibuf[7];
-      camera->socket_num=iface->ibuf[8];
+      camera->vendor=(packet.bytes[2]<<8) + packet.bytes[3];
+      camera->model=(packet.bytes[4]<<8) + packet.bytes[5];
+      camera->rom_version=(packet.bytes[6]<<8) + packet.bytes[7];
+      camera->socket_num=packet.bytes[8];
       return VISCA_SUCCESS;
     }
 }
 
+/***********************************/
+/*       COMMAND TEMPLATES         */
+/***********************************/
+
+/* Most commands are a fixed byte string with a few parameter fields.
+ * They are described here as templates, filled into the packet in a
+ * single pass. Message bodies never contain bytes with the high bit
+ * set, so those encode the slots:
+ *   10aa akkk   nibble k of argument a
+ *   11aa aaaa   low byte of argument a
+ * Each template is declared with the number of arguments its slots
+ * take. Its length and argument count are checked at compile time.
+ */
+#define _VISCA_NIBBLE(a, k)  (0x80|((a)<<3)|(k))
+#define _VISCA_NIBBLES2(a)   _VISCA_NIBBLE(a, 1), _VISCA_NIBBLE(a, 0)
+#define _VISCA_NIBBLES4(a)   _VISCA_NIBBLE(a, 3), _VISCA_NIBBLE(a, 2), _VISCA_NIBBLES2(a)
+#define _VISCA_NIBBLES5(a)   _VISCA_NIBBLE(a, 4), _VISCA_NIBBLES4(a)
+#define _VISCA_BYTE(a)       (0xC0|(a))
+#define _VISCA_TEMPLATE_ARGS 8
+
+typedef struct _VISCA_template
+{
+  const unsigned char *bytes;
+  unsigned char length;
+  unsigned char nargs;
+} _VISCA_template_t;
+
+#define _VISCA_TEMPLATE(name, nargs, ...) \
+  static const unsigned char name##_bytes[]={ __VA_ARGS__ }; \
+  static const _VISCA_template_t name={ name##_bytes, sizeof(name##_bytes), nargs }; \
+  typedef char name##_fits[((sizeof(name##_bytes)<=sizeof(((VISCAPacket_t *)0)->bytes)-2)&& \
+			    ((nargs)<=_VISCA_TEMPLATE_ARGS))?1:-1]
+
+/* Send the command of tmpl, its nargs arguments following as uint32_t.
+ * The command is encoded right into the packet of the request that
+ * carries it.
+ */
+static uint32_t
+_VISCA_send_template(VISCAInterface_t *iface, VISCACamera_t *camera, const _VISCA_template_t *tmpl, ...)
+{
+  VISCARequest_t req;
+  uint32_t arg[_VISCA_TEMPLATE_ARGS];
+  unsigned char *byte=&req.packet.bytes[1];
+  const unsigned char *slot=tmpl->bytes;
+  uint32_t err;
+  int a;
+  size_t i;
+  va_list ap;
+
+  va_start(ap, tmpl);
+  for (a=0;a<tmpl->nargs;a++)
+    arg[a]=va_arg(ap, uint32_t);
+  va_end(ap);
+
+  for (i=0;i<tmpl->length;i++)
+    {
+      if (!(slot[i]&0x80))
+        *byte++=slot[i];
+      else if (slot[i]&0x40)
+        *byte++=(unsigned char)arg[slot[i]&0x3F];
+      else
+        *byte++=(arg[(slot[i]>>3)&0x7]>>(4*(slot[i]&0x7)))&0xF;
+    }
+  req.packet.length=tmpl->length+1;
+
+  err=_VISCA_request_with_reply(iface, camera, &req, iface->timeout);
+  if (err!=VISCA_SUCCESS)
+    return err;
+
+  return req.error;
+}
+
+_VISCA_TEMPLATE(_VISCA_tmpl_set_power, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_POWER, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_keylock, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_KEYLOCK, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_camera_id, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ID, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_tele, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, VISCA_ZOOM_TELE);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_wide, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, VISCA_ZOOM_WIDE);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_stop, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, VISCA_ZOOM_STOP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_tele_speed, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_wide_speed, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zoom_and_focus_value, 2, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM_FOCUS_VALUE, _VISCA_NIBBLES4(0), _VISCA_NIBBLES4(1));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_dzoom, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DZOOM, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_dzoom_limit, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DZOOM_LIMIT, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_dzoom_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DZOOM_MODE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_far, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS, VISCA_FOCUS_FAR);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_near, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS, VISCA_FOCUS_NEAR);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_stop, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS, VISCA_FOCUS_STOP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_far_speed, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_near_speed, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_auto, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_AUTO, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_one_push, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_ONE_PUSH, VISCA_FOCUS_ONE_PUSH_TRIG);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_infinity, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_ONE_PUSH, VISCA_FOCUS_ONE_PUSH_INF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_autosense_high, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_AUTO_SENSE, VISCA_FOCUS_AUTO_SENSE_HIGH);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_autosense_low, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_AUTO_SENSE, VISCA_FOCUS_AUTO_SENSE_LOW);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_focus_near_limit, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_NEAR_LIMIT, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_whitebal_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_WB, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_whitebal_one_push, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_WB_TRIGGER, VISCA_WB_ONE_PUSH_TRIG);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_rgain_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_RGAIN, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_rgain_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_RGAIN, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_rgain_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_RGAIN, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_rgain_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_RGAIN_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bgain_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BGAIN, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bgain_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BGAIN, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bgain_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BGAIN, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bgain_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BGAIN_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_shutter_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SHUTTER, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_shutter_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SHUTTER, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_shutter_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SHUTTER, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_shutter_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SHUTTER_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_iris_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_IRIS, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_iris_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_IRIS, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_iris_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_IRIS, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_iris_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_IRIS_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_gain_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_GAIN, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_gain_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_GAIN, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_gain_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_GAIN, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_gain_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_GAIN_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bright_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BRIGHT, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bright_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BRIGHT, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bright_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BRIGHT, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_bright_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BRIGHT_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_aperture_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_APERTURE, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_aperture_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_APERTURE, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_aperture_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_APERTURE, VISCA_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_aperture_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_APERTURE_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_exp_comp_up, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP, VISCA_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_exp_comp_down, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP, VISCA_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_exp_comp_value, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP_VALUE, _VISCA_NIBBLES4(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_exp_comp_power, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP_POWER, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_auto_exp_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_AUTO_EXP, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_slow_shutter_auto, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SLOW_SHUTTER, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_backlight_comp, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_BACKLIGHT_COMP, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_zero_lux_shot, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZERO_LUX, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_ir_led, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_IR_LED, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_wide_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_WIDE_MODE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_mirror, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_MIRROR, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_freeze, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FREEZE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_picture_effect, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_PICTURE_EFFECT, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_digital_effect, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DIGITAL_EFFECT, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_digital_effect_level, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DIGITAL_EFFECT_LEVEL, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_cam_stabilizer, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_CAM_STABILIZER, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_display, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DISPLAY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_date_display, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_DATE_DISPLAY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_time_display, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_TIME_DISPLAY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_title_display, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_TITLE_DISPLAY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_title_clear, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_TITLE_DISPLAY, VISCA_TITLE_DISPLAY_CLEAR);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_title_params, 4, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_TITLE_SET, VISCA_TITLE_SET_PARAMS, _VISCA_BYTE(0), _VISCA_BYTE(1), _VISCA_BYTE(2), _VISCA_BYTE(3), 0, 0, 0, 0, 0, 0);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_spot_ae_on, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SPOT_AE, VISCA_SPOT_AE_ON);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_spot_ae_off, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SPOT_AE, VISCA_SPOT_AE_OFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_spot_ae_position, 2, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_SPOT_AE_POSITION, _VISCA_NIBBLES2(0), _VISCA_NIBBLES2(1));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_irreceive_on, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_IRRECEIVE, VISCA_IRRECEIVE_ON);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_irreceive_off, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_IRRECEIVE, VISCA_IRRECEIVE_OFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_irreceive_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_IRRECEIVE, VISCA_IRRECEIVE_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_up, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_STOP, VISCA_PT_DRIVE_VERT_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_down, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_STOP, VISCA_PT_DRIVE_VERT_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_left, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_LEFT, VISCA_PT_DRIVE_VERT_STOP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_right, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_RIGHT, VISCA_PT_DRIVE_VERT_STOP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_upleft, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_LEFT, VISCA_PT_DRIVE_VERT_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_upright, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_RIGHT, VISCA_PT_DRIVE_VERT_UP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_downleft, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_LEFT, VISCA_PT_DRIVE_VERT_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_downright, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_RIGHT, VISCA_PT_DRIVE_VERT_DOWN);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_stop, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE, _VISCA_BYTE(0), _VISCA_BYTE(1), VISCA_PT_DRIVE_HORIZ_STOP, VISCA_PT_DRIVE_VERT_STOP);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_absolute_position, 4, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_ABSOLUTE_POSITION, _VISCA_BYTE(0), _VISCA_BYTE(1), _VISCA_NIBBLES5(2), _VISCA_NIBBLES4(3));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_relative_position, 4, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_RELATIVE_POSITION, _VISCA_BYTE(0), _VISCA_BYTE(1), _VISCA_NIBBLES5(2), _VISCA_NIBBLES4(3));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_home, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_HOME);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_reset, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_RESET);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_limit_upright, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_LIMITSET, VISCA_PT_LIMITSET_SET, VISCA_PT_LIMITSET_SET_UR, _VISCA_NIBBLES4(0), _VISCA_NIBBLES4(1));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_pantilt_limit_downleft, 2, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_LIMITSET, VISCA_PT_LIMITSET_SET, VISCA_PT_LIMITSET_SET_DL, _VISCA_NIBBLES4(0), _VISCA_NIBBLES4(1));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_datascreen_on, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DATASCREEN, VISCA_PT_DATASCREEN_ON);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_datascreen_off, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DATASCREEN, VISCA_PT_DATASCREEN_OFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_datascreen_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DATASCREEN, VISCA_PT_DATASCREEN_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_register, 2, VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_REGISTER_VALUE, _VISCA_BYTE(0), _VISCA_NIBBLES2(1));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_wide_con_lens, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_WIDE_CON_LENS, VISCA_WIDE_CON_LENS_SET, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_mode_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_MODE, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_MODE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_ae_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_AE, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_ae, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_AE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_autozoom_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_AUTOZOOM, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_autozoom, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_AUTOZOOM, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_atmd_framedisplay_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_ATMD_FRAMEDISPLAY, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_atmd_framedisplay, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_ATMD_FRAMEDISPLAY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_frameoffset_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_FRAMEOFFSET, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_frameoffset, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_FRAMEOFFSET, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_atmd_startstop, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_ATMD_STARTSTOP, VISCA_AT_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_chase, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_CHASE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_chase_next, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_CHASE, VISCA_AT_CHASE_NEXT);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_mode_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MODE, VISCA_MD_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_mode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MODE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_frame, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_FRAME);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_detect, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_DETECT, VISCA_MD_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_entry, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_AT_ENTRY, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_at_lostinfo, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_ATMD_LOSTINFO1, VISCA_ATMD_LOSTINFO2, VISCA_AT_LOSTINFO);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_lostinfo, 0, VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_ATMD_LOSTINFO1, VISCA_ATMD_LOSTINFO2, VISCA_MD_LOSTINFO);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_ylevel, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_YLEVEL, VISCA_MD_ADJUST, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_huelevel, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_HUELEVEL, VISCA_MD_ADJUST, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_size, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_SIZE, VISCA_MD_ADJUST, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_disptime, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_DISPTIME, VISCA_MD_ADJUST, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_refmode, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_REFMODE, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_adjust_reftime, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_ADJUST_REFTIME, VISCA_MD_ADJUST, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_measure_mode1_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MEASURE_MODE_1, VISCA_MD_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_measure_mode1, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MEASURE_MODE_1, _VISCA_BYTE(0));
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_measure_mode2_onoff, 0, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MEASURE_MODE_2, VISCA_MD_ONOFF);
+_VISCA_TEMPLATE(_VISCA_tmpl_set_md_measure_mode2, 1, VISCA_COMMAND, VISCA_CATEGORY_CAMERA2, VISCA_MD_MEASURE_MODE_2, _VISCA_BYTE(0));
+
+
 /***********************************/
 /*       COMMAND FUNCTIONS         */
 /***********************************/
@@ -218,897 +1809,399 @@ VISCA_get_camera_info(VISCAInterface_t *iface, VISCACamera_t *camera)
 uint32_t
 VISCA_set_power(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_POWER);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_power, power);
 }
 
 
 uint32_t
 VISCA_set_keylock(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_KEYLOCK);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_keylock, power);
 }
 
 
 uint32_t
 VISCA_set_camera_id(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t id)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ID);
-  _VISCA_append_byte(&packet, (id & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (id & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (id & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (id & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_camera_id, id);
 }
 
 
 uint32_t
 VISCA_set_zoom_tele(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_TELE);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_tele);
 }
 
 
 uint32_t
 VISCA_set_zoom_wide(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_WIDE);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_wide);
 }
 
 
 uint32_t
 VISCA_set_zoom_stop(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_STOP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_stop);
 }
 
 
 uint32_t
 VISCA_set_zoom_tele_speed(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_TELE_SPEED | (speed & 0x7));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_tele_speed, VISCA_ZOOM_TELE_SPEED | (speed & 0x7));
 }
 
 
-uint32_t
-VISCA_set_zoom_wide_speed(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t speed)
-{
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_WIDE_SPEED | (speed & 0x7));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
-
+uint32_t
+VISCA_set_zoom_wide_speed(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t speed)
+{
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_wide_speed, VISCA_ZOOM_WIDE_SPEED | (speed & 0x7));
 }
 
 
 uint32_t
 VISCA_set_zoom_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t zoom)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_VALUE);
-  _VISCA_append_byte(&packet, (zoom & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (zoom & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (zoom & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (zoom & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_value, zoom);
 }
 
 
 uint32_t
 VISCA_set_zoom_and_focus_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t zoom, uint32_t focus)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZOOM_FOCUS_VALUE);
-  _VISCA_append_byte(&packet, (zoom & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (zoom & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (zoom & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (zoom & 0x000F));
-  _VISCA_append_byte(&packet, (focus & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (focus & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (focus & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (focus & 0x000F));
- 
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zoom_and_focus_value, zoom, focus);
 }
 
 
 uint32_t
 VISCA_set_dzoom(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DZOOM);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_dzoom, power);
 }
 
 
 uint32_t
 VISCA_set_dzoom_limit(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t limit)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DZOOM_LIMIT);
-  _VISCA_append_byte(&packet, limit);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_dzoom_limit, limit);
 }
 
 
 uint32_t
 VISCA_set_dzoom_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DZOOM_MODE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_dzoom_mode, power);
 }
 
 
 uint32_t
 VISCA_set_focus_far(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_FAR);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_far);
 }
 
 
 uint32_t
 VISCA_set_focus_near(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_NEAR);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_near);
 }
 
 
 uint32_t
 VISCA_set_focus_stop(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_STOP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_stop);
 }
 
 
 uint32_t
 VISCA_set_focus_far_speed(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_FAR_SPEED | (speed & 0x7));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_far_speed, VISCA_FOCUS_FAR_SPEED | (speed & 0x7));
 }
 
 
 uint32_t
 VISCA_set_focus_near_speed(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_NEAR_SPEED | (speed & 0x7));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_near_speed, VISCA_FOCUS_NEAR_SPEED | (speed & 0x7));
 }
 
 
 uint32_t
 VISCA_set_focus_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t focus)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_VALUE);
-  _VISCA_append_byte(&packet, (focus & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (focus & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (focus & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (focus & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_value, focus);
 }
 
 
 uint32_t
 VISCA_set_focus_auto(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_AUTO);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_auto, power);
 }
 
 
 uint32_t
 VISCA_set_focus_one_push(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_ONE_PUSH);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_ONE_PUSH_TRIG);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_one_push);
 }
 
 
 uint32_t
 VISCA_set_focus_infinity(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_ONE_PUSH);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_ONE_PUSH_INF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_infinity);
 }
 
 
 uint32_t
 VISCA_set_focus_autosense_high(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_AUTO_SENSE);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_AUTO_SENSE_HIGH);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_autosense_high);
 }
 
 
 uint32_t
 VISCA_set_focus_autosense_low(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_AUTO_SENSE);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_AUTO_SENSE_LOW);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_autosense_low);
 }
 
 
 uint32_t
 VISCA_set_focus_near_limit(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t limit)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FOCUS_NEAR_LIMIT);
-  _VISCA_append_byte(&packet, (limit & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (limit & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (limit & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (limit & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_focus_near_limit, limit);
 }
 
 
 uint32_t
 VISCA_set_whitebal_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t mode)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_WB);
-  _VISCA_append_byte(&packet, mode);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_whitebal_mode, mode);
 }
 
 
 uint32_t
 VISCA_set_whitebal_one_push(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_WB_TRIGGER);
-  _VISCA_append_byte(&packet, VISCA_WB_ONE_PUSH_TRIG);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_whitebal_one_push);
 }
 
 
 uint32_t
 VISCA_set_rgain_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_RGAIN);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_rgain_up);
 }
 
 
 uint32_t
 VISCA_set_rgain_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_RGAIN);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_rgain_down);
 }
 
 
 uint32_t
 VISCA_set_rgain_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_RGAIN);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
-
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_rgain_reset);
 }
 
 
 uint32_t
 VISCA_set_rgain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_RGAIN_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_rgain_value, value);
 }
 
 
 uint32_t
 VISCA_set_bgain_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BGAIN);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bgain_up);
 }
 
 
 uint32_t
 VISCA_set_bgain_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BGAIN);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bgain_down);
 }
 
 
 uint32_t
 VISCA_set_bgain_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BGAIN);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bgain_reset);
 }
 
 
 uint32_t
 VISCA_set_bgain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BGAIN_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
- _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bgain_value, value);
 }
 
 
 uint32_t
 VISCA_set_shutter_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SHUTTER);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_shutter_up);
 }
 
 
 uint32_t
 VISCA_set_shutter_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SHUTTER);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_shutter_down);
 }
 
 
 uint32_t
 VISCA_set_shutter_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SHUTTER);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_shutter_reset);
 }
 
 
 uint32_t
 VISCA_set_shutter_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SHUTTER_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
- _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_shutter_value, value);
 }
 
 
 uint32_t
 VISCA_set_iris_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_IRIS);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_iris_up);
 }
 
 
 uint32_t
 VISCA_set_iris_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_IRIS);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_iris_down);
 }
 
 
 uint32_t
 VISCA_set_iris_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_IRIS);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_iris_reset);
 }
 
 
 uint32_t
 VISCA_set_iris_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_IRIS_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
- _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_iris_value, value);
 }
 
 
 uint32_t
 VISCA_set_gain_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_GAIN);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_gain_up);
 }
 
 
 uint32_t
 VISCA_set_gain_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_GAIN);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_gain_down);
 }
 
 
 uint32_t
 VISCA_set_gain_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_GAIN);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_gain_reset);
 }
 
 
 uint32_t
 VISCA_set_gain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_GAIN_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_gain_value, value);
 }
 
 
 uint32_t
 VISCA_set_bright_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BRIGHT);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bright_up);
 }
 
 
 uint32_t
 VISCA_set_bright_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BRIGHT);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bright_down);
 }
 
 
 uint32_t
 VISCA_set_bright_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BRIGHT);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bright_reset);
 }
 
 
 uint32_t
 VISCA_set_bright_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BRIGHT_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_bright_value, value);
 }
 
 
 uint32_t
 VISCA_set_aperture_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_APERTURE);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_aperture_up);
 }
 
 
 uint32_t
 VISCA_set_aperture_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_APERTURE);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_aperture_down);
 }
 
 
 uint32_t
 VISCA_set_aperture_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_APERTURE);
-  _VISCA_append_byte(&packet, VISCA_RESET);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_aperture_reset);
 }
 
 
 uint32_t
 VISCA_set_aperture_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_APERTURE_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_aperture_value, value);
 }
 
 
 uint32_t
 VISCA_set_exp_comp_up(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_EXP_COMP);
-  _VISCA_append_byte(&packet, VISCA_UP);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_exp_comp_up);
 }
 
 
 uint32_t
 VISCA_set_exp_comp_down(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_EXP_COMP);
-  _VISCA_append_byte(&packet, VISCA_DOWN);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_exp_comp_down);
 }
 
 
@@ -1132,213 +2225,98 @@ VISCA_set_exp_comp_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 uint32_t
 VISCA_set_exp_comp_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t value)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_EXP_COMP_VALUE);
-  _VISCA_append_byte(&packet, (value & 0xF000) >> 12);
-  _VISCA_append_byte(&packet, (value & 0x0F00) >>  8);
-  _VISCA_append_byte(&packet, (value & 0x00F0) >>  4);
-  _VISCA_append_byte(&packet, (value & 0x000F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_exp_comp_value, value);
 }
 
 
 uint32_t
 VISCA_set_exp_comp_power(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_EXP_COMP_POWER);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_exp_comp_power, power);
 }
 
 
 uint32_t
 VISCA_set_auto_exp_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t mode)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_AUTO_EXP);
-  _VISCA_append_byte(&packet, mode);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_auto_exp_mode, mode);
 }
 
 
 uint32_t
 VISCA_set_slow_shutter_auto(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SLOW_SHUTTER);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_slow_shutter_auto, power);
 }
 
 
 uint32_t
 VISCA_set_backlight_comp(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_BACKLIGHT_COMP);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_backlight_comp, power);
 }
 
 
 uint32_t
 VISCA_set_zero_lux_shot(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_ZERO_LUX);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_zero_lux_shot, power);
 }
 
 
 uint32_t
 VISCA_set_ir_led(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_IR_LED);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_ir_led, power);
 }
 
 
 uint32_t
 VISCA_set_wide_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t mode)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_WIDE_MODE);
-  _VISCA_append_byte(&packet, mode);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_wide_mode, mode);
 }
 
 
 uint32_t
 VISCA_set_mirror(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_MIRROR);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_mirror, power);
 }
 
 
 uint32_t
 VISCA_set_freeze(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_FREEZE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_freeze, power);
 }
 
 
 uint32_t
 VISCA_set_picture_effect(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t mode)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_PICTURE_EFFECT);
-  _VISCA_append_byte(&packet, mode);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_picture_effect, mode);
 }
 
 
 uint32_t
 VISCA_set_digital_effect(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t mode)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DIGITAL_EFFECT);
-  _VISCA_append_byte(&packet, mode);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_digital_effect, mode);
 }
 
 
 uint32_t
 VISCA_set_digital_effect_level(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t level)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DIGITAL_EFFECT_LEVEL);
-  _VISCA_append_byte(&packet, level);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_digital_effect_level, level);
 }
 
 
 uint32_t
 VISCA_set_cam_stabilizer(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-  
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_CAM_STABILIZER);
-  _VISCA_append_byte(&packet, power);
-  
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_cam_stabilizer, power);
 }
 
 
@@ -1393,15 +2371,7 @@ VISCA_memory_reset(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t chann
 uint32_t
 VISCA_set_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DISPLAY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_display, power);
 }
 
 
@@ -1432,85 +2402,35 @@ VISCA_set_date_time(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t yea
 uint32_t
 VISCA_set_date_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_DATE_DISPLAY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_date_display, power);
 }
 
 
 uint32_t
 VISCA_set_time_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_TIME_DISPLAY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_time_display, power);
 }
 
 
 uint32_t
-VISCA_set_title_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
-{
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_TITLE_DISPLAY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+VISCA_set_title_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
+{
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_title_display, power);
 }
 
 
 uint32_t
 VISCA_set_title_clear(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_TITLE_DISPLAY);
-  _VISCA_append_byte(&packet, VISCA_TITLE_DISPLAY_CLEAR);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_title_clear);
 }
 
 
 uint32_t
 VISCA_set_title_params(VISCAInterface_t *iface, VISCACamera_t *camera, VISCATitleData_t *title)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_TITLE_SET);
-  _VISCA_append_byte(&packet, VISCA_TITLE_SET_PARAMS);
-  _VISCA_append_byte(&packet, title->vposition);
-  _VISCA_append_byte(&packet, title->hposition);
-  _VISCA_append_byte(&packet, title->color);
-  _VISCA_append_byte(&packet, title->blink);
-  _VISCA_append_byte(&packet, 0);
-  _VISCA_append_byte(&packet, 0);
-  _VISCA_append_byte(&packet, 0);
-  _VISCA_append_byte(&packet, 0);
-  _VISCA_append_byte(&packet, 0);
-  _VISCA_append_byte(&packet, 0);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_title_params, title->vposition, title->hposition, title->color, title->blink);
 }
 
 
@@ -1549,48 +2469,21 @@ VISCA_set_title(VISCAInterface_t *iface, VISCACamera_t *camera, VISCATitleData_t
 uint32_t
 VISCA_set_spot_ae_on(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SPOT_AE);
-  _VISCA_append_byte(&packet, VISCA_SPOT_AE_ON);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_spot_ae_on);
 }
 
 
 uint32_t
 VISCA_set_spot_ae_off(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SPOT_AE);
-  _VISCA_append_byte(&packet, VISCA_SPOT_AE_OFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_spot_ae_off);
 }
 
 
 uint32_t
 VISCA_set_spot_ae_position(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t x_position, uint8_t y_position)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_SPOT_AE_POSITION);
-  _VISCA_append_byte(&packet, (x_position & 0xF0) >>  4);
-  _VISCA_append_byte(&packet, (x_position & 0x0F));
-  _VISCA_append_byte(&packet, (y_position & 0xF0) >>  4);
-  _VISCA_append_byte(&packet, (y_position & 0x0F));
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_spot_ae_position, x_position, y_position);
 }
 
 
@@ -1613,7 +2506,7 @@ VISCA_get_power(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power)
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1633,7 +2526,7 @@ VISCA_get_dzoom(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power)
   if (err!=VISCA_SUCCESS)
     return err;
   else {
-    *power=iface->ibuf[2];
+    *power=packet.bytes[2];
     return VISCA_SUCCESS;
   }
 }
@@ -1653,7 +2546,7 @@ VISCA_get_dzoom_limit(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *v
   if (err!=VISCA_SUCCESS)
     return err;
   else {
-    *value=iface->ibuf[2];
+    *value=packet.bytes[2];
     return VISCA_SUCCESS;
   }
 }
@@ -1674,7 +2567,7 @@ VISCA_get_zoom_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *v
   if (err!=VISCA_SUCCESS)
     return err;
   else {
-    *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+    *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
     return VISCA_SUCCESS;
   }
 
@@ -1696,7 +2589,7 @@ VISCA_get_focus_auto(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *po
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1717,7 +2610,7 @@ VISCA_get_focus_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1738,7 +2631,7 @@ VISCA_get_focus_auto_sense(VISCAInterface_t *iface, VISCACamera_t *camera, uint8
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1759,7 +2652,7 @@ VISCA_get_focus_near_limit(VISCAInterface_t *iface, VISCACamera_t *camera, uint1
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1780,7 +2673,7 @@ VISCA_get_whitebal_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1801,7 +2694,7 @@ VISCA_get_rgain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1822,7 +2715,7 @@ VISCA_get_bgain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1843,7 +2736,7 @@ VISCA_get_auto_exp_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1864,7 +2757,7 @@ VISCA_get_slow_shutter_auto(VISCAInterface_t *iface, VISCACamera_t *camera, uint
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1885,7 +2778,7 @@ VISCA_get_shutter_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1906,7 +2799,7 @@ VISCA_get_iris_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *v
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1927,7 +2820,7 @@ VISCA_get_gain_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *v
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1948,7 +2841,7 @@ VISCA_get_bright_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -1969,7 +2862,7 @@ VISCA_get_exp_comp_power(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -1990,7 +2883,7 @@ VISCA_get_exp_comp_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -2011,7 +2904,7 @@ VISCA_get_backlight_comp(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2032,7 +2925,7 @@ VISCA_get_aperture_value(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -2053,7 +2946,7 @@ VISCA_get_zero_lux_shot(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2074,7 +2967,7 @@ VISCA_get_ir_led(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power)
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2095,7 +2988,7 @@ VISCA_get_wide_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *mod
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2116,7 +3009,7 @@ VISCA_get_mirror(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power)
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2137,7 +3030,7 @@ VISCA_get_freeze(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power)
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2158,7 +3051,7 @@ VISCA_get_picture_effect(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2179,7 +3072,7 @@ VISCA_get_digital_effect(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *mode=iface->ibuf[2];
+      *mode=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2200,7 +3093,7 @@ VISCA_get_digital_effect_level(VISCAInterface_t *iface, VISCACamera_t *camera, u
     return err;
   else
     {
-      *value=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *value=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
@@ -2221,7 +3114,7 @@ VISCA_get_memory(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *channe
     return err;
   else
     {
-      *channel=iface->ibuf[2];
+      *channel=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2242,7 +3135,7 @@ VISCA_get_display(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2263,334 +3156,119 @@ VISCA_get_id(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *id)
     return err;
   else
     {
-      *id=(iface->ibuf[2]<<12)+(iface->ibuf[3]<<8)+(iface->ibuf[4]<<4)+iface->ibuf[5];
+      *id=(packet.bytes[2]<<12)+(packet.bytes[3]<<8)+(packet.bytes[4]<<4)+packet.bytes[5];
       return VISCA_SUCCESS;
     }
 }
 uint32_t
 VISCA_set_irreceive_on(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE_ON);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_irreceive_on);
 }
 
 uint32_t
 VISCA_set_irreceive_off(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE_OFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_irreceive_off);
 }
 
 uint32_t
 VISCA_set_irreceive_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE);
-  _VISCA_append_byte(&packet, VISCA_IRRECEIVE_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_irreceive_onoff);
 }
 
 
 uint32_t
 VISCA_set_pantilt_up(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_STOP);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_UP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_up, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_down(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_STOP);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_DOWN);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_down, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_left(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_LEFT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_STOP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_left, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_right(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_RIGHT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_STOP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_right, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_upleft(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_LEFT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_UP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_upleft, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_upright(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_RIGHT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_UP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_upright, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_downleft(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_LEFT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_DOWN);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_downleft, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_downright(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_RIGHT);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_DOWN);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_downright, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_stop(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_HORIZ_STOP);
-  _VISCA_append_byte(&packet, VISCA_PT_DRIVE_VERT_STOP);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_stop, pan_speed, tilt_speed);
 }
 
 uint32_t
 VISCA_set_pantilt_absolute_position(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed, int pan_position, int tilt_position)
 {
-  VISCAPacket_t packet;
-
-  uint32_t pan_pos=(uint32_t) pan_position;
-  uint32_t tilt_pos=(uint32_t) tilt_position;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_ABSOLUTE_POSITION);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, (pan_pos & 0xf0000) >> 16);
-  _VISCA_append_byte(&packet, (pan_pos & 0x0f000) >> 12);
-  _VISCA_append_byte(&packet, (pan_pos & 0x00f00) >>  8);
-  _VISCA_append_byte(&packet, (pan_pos & 0x000f0) >>  4);
-  _VISCA_append_byte(&packet,  pan_pos & 0x0000f       );
-
-  _VISCA_append_byte(&packet, (tilt_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, tilt_pos & 0x000f);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_absolute_position, pan_speed, tilt_speed, (uint32_t)pan_position, (uint32_t)tilt_position);
 }
 
 
 uint32_t
 VISCA_set_pantilt_relative_position(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t pan_speed, uint32_t tilt_speed, int pan_position, int tilt_position)
 {
-  VISCAPacket_t packet;
-
-  uint32_t pan_pos=(uint32_t) pan_position;
-  uint32_t tilt_pos=(uint32_t) tilt_position;
-  
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_RELATIVE_POSITION);
-  _VISCA_append_byte(&packet, pan_speed);
-  _VISCA_append_byte(&packet, tilt_speed);
-  _VISCA_append_byte(&packet, (pan_pos & 0xf0000) >> 16);
-  _VISCA_append_byte(&packet, (pan_pos & 0x0f000) >> 12);
-  _VISCA_append_byte(&packet, (pan_pos & 0x00f00) >>  8);
-  _VISCA_append_byte(&packet, (pan_pos & 0x000f0) >>  4);
-  _VISCA_append_byte(&packet,  pan_pos & 0x0000f       );
-
-  _VISCA_append_byte(&packet, (tilt_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, tilt_pos & 0x000f);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_relative_position, pan_speed, tilt_speed, (uint32_t)pan_position, (uint32_t)tilt_position);
 }
 
 uint32_t
 VISCA_set_pantilt_home(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_HOME);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_home);
 }
 
 uint32_t
 VISCA_set_pantilt_reset(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_RESET);
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_reset);
 }
 
 uint32_t
 VISCA_set_pantilt_limit_upright(VISCAInterface_t *iface, VISCACamera_t *camera, int pan_position, int tilt_position)
 {
-  VISCAPacket_t packet;
-
-  uint32_t pan_pos=(uint32_t) pan_position;
-  uint32_t tilt_pos=(uint32_t) tilt_position;
-  
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET_SET);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET_SET_UR);
-  _VISCA_append_byte(&packet, (pan_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (pan_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (pan_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, pan_pos & 0x000f);
-
-  _VISCA_append_byte(&packet, (tilt_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, tilt_pos & 0x000f);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_limit_upright, (uint32_t)pan_position, (uint32_t)tilt_position);
 }
 
 
 uint32_t
 VISCA_set_pantilt_limit_downleft(VISCAInterface_t *iface, VISCACamera_t *camera, int pan_position, int tilt_position)
 {
-  VISCAPacket_t packet;
-
-  uint32_t pan_pos=(uint32_t) pan_position;
-  uint32_t tilt_pos=(uint32_t) tilt_position;
-  
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET_SET);
-  _VISCA_append_byte(&packet, VISCA_PT_LIMITSET_SET_DL);
-  _VISCA_append_byte(&packet, (pan_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (pan_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (pan_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, pan_pos & 0x000f);
-
-  _VISCA_append_byte(&packet, (tilt_pos & 0xf000) >> 12);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x0f00) >> 8);
-  _VISCA_append_byte(&packet, (tilt_pos & 0x00f0) >> 4);
-  _VISCA_append_byte(&packet, tilt_pos & 0x000f);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_pantilt_limit_downleft, (uint32_t)pan_position, (uint32_t)tilt_position);
 }
 
 
@@ -2653,59 +3331,26 @@ VISCA_set_pantilt_limit_upright_clear(VISCAInterface_t *iface, VISCACamera_t *ca
 uint32_t
 VISCA_set_datascreen_on(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN_ON);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_datascreen_on);
 }
 
 uint32_t
 VISCA_set_datascreen_off(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN_OFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_datascreen_off);
 }
 
 uint32_t
 VISCA_set_datascreen_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN);
-  _VISCA_append_byte(&packet, VISCA_PT_DATASCREEN_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_datascreen_onoff);
 }
 
-
-uint32_t
-VISCA_set_register(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t reg_num, uint8_t reg_val)
-{
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA1);
-  _VISCA_append_byte(&packet, VISCA_REGISTER_VALUE);
-  _VISCA_append_byte(&packet, reg_num);
-  _VISCA_append_byte(&packet, (reg_val & 0xF0) >>  4);
-  _VISCA_append_byte(&packet, (reg_val & 0x0F));
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+
+uint32_t
+VISCA_set_register(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t reg_num, uint8_t reg_val)
+{
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_register, reg_num, reg_val);
 }
 
 
@@ -2728,7 +3373,7 @@ VISCA_get_videosystem(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *s
     return err;
   else
     {
-      *system=iface->ibuf[2];
+      *system=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2748,7 +3393,7 @@ VISCA_get_pantilt_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t
     return err;
   else
     {
-      *status = ((iface->ibuf[2] & 0xff) << 8) + (iface->ibuf[3] & 0xff);
+      *status = ((packet.bytes[2] & 0xff) << 8) + (packet.bytes[3] & 0xff);
       return VISCA_SUCCESS;
     }
 }
@@ -2768,8 +3413,8 @@ VISCA_get_pantilt_maxspeed(VISCAInterface_t *iface, VISCACamera_t *camera, uint8
     return err;
   else
     {
-      *max_pan_speed = (iface->ibuf[2] & 0xff);
-      *max_tilt_speed = (iface->ibuf[3] & 0xff);
+      *max_pan_speed = (packet.bytes[2] & 0xff);
+      *max_tilt_speed = (packet.bytes[3] & 0xff);
       return VISCA_SUCCESS;
     }
 }
@@ -2790,10 +3435,10 @@ VISCA_get_pantilt_position(VISCAInterface_t *iface, VISCACamera_t *camera, int *
     return err;
   else
     {
-      pan_pos  = ((iface->ibuf[3] & 0xf) << 12) + ((iface->ibuf[4] & 0xf) << 8) + ((iface->ibuf[5] & 0xf) << 4) + (iface->ibuf[6] & 0xf); 
-      tilt_pos = ((iface->ibuf[7] & 0xf) << 12) + ((iface->ibuf[8] & 0xf) << 8) + ((iface->ibuf[9] & 0xf) << 4) + (iface->ibuf[10] & 0xf); 
+      pan_pos  = ((packet.bytes[3] & 0xf) << 12) + ((packet.bytes[4] & 0xf) << 8) + ((packet.bytes[5] & 0xf) << 4) + (packet.bytes[6] & 0xf); 
+      tilt_pos = ((packet.bytes[7] & 0xf) << 12) + ((packet.bytes[8] & 0xf) << 8) + ((packet.bytes[9] & 0xf) << 4) + (packet.bytes[10] & 0xf); 
 
-      if (!iface->ibuf[2]) *pan_position=pan_pos;
+      if (!packet.bytes[2]) *pan_position=pan_pos;
       else *pan_position=((int)pan_pos) - 65536;
       if (tilt_pos<0x8000) *tilt_position=tilt_pos;
       else *tilt_position=((int)tilt_pos) - 65536;
@@ -2817,7 +3462,7 @@ VISCA_get_datascreen(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *st
     return err;
   else
     {
-      *status=iface->ibuf[2];
+      *status=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -2839,484 +3484,329 @@ VISCA_get_register(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t reg_n
     return err;
   else
     {
-      *reg_val=(iface->ibuf[2]<<4)+iface->ibuf[3];
+      *reg_val=(packet.bytes[2]<<4)+packet.bytes[3];
       return VISCA_SUCCESS;
     }
 }
 
 
-/********************************/
-/* SPECIAL FUNCTIONS FOR D30/31 */
-/********************************/
+/* Block replies are y0 50, 13 bytes, FF. The lens control block is
+ *   0p 0q 0r 0s  zoom position
+ *   0p 0q        focus near limit, upper byte
+ *   0p 0q 0r 0s  focus position
+ *   00
+ *   WW           bit 0 auto focus, bit 1 normal AF sensitivity,
+ *                bit 2 digital zoom, bits 3-4 AF mode
+ *   VV           bit 0 zooming, bit 1 focusing, bit 2 memory recall
+ * and the camera control block
+ *   0p 0q        R gain
+ *   0p 0q        B gain
+ *   0p           white balance mode
+ *   0p           aperture gain
+ *   pp           exposure mode
+ *   WW           bit 0 auto slow shutter, bit 1 exposure compensation,
+ *                bit 2 back light compensation
+ *   pp pp pp pp pp  shutter, iris, gain, bright and exposure
+ *                compensation positions
+ */
+#define _VISCA_ONOFF(bits, bit) ((((bits)>>(bit))&1) ? VISCA_ON : VISCA_OFF)
 
 uint32_t
-VISCA_set_wide_con_lens(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
+VISCA_get_block(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t block, VISCABlock_t *status)
 {
   VISCAPacket_t packet;
+  unsigned char *r;
+  uint32_t err;
+
+  if (block>=VISCA_BLOCKS)
+    return VISCA_FAILURE;
 
   _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_WIDE_CON_LENS);
-  _VISCA_append_byte(&packet, VISCA_WIDE_CON_LENS_SET);
-  _VISCA_append_byte(&packet, power);
+  _VISCA_append_byte(&packet, VISCA_INQUIRY);
+  _VISCA_append_byte(&packet, VISCA_BLOCK_INQUIRY);
+  _VISCA_append_byte(&packet, VISCA_BLOCK_INQUIRY);
+  _VISCA_append_byte(&packet, block);
+  err=_VISCA_send_packet_with_reply(iface, camera, &packet);
+  if (err!=VISCA_SUCCESS)
+    return err;
+  if (packet.length<16)
+    return VISCA_SHORT_REPLY;
 
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  r=&packet.bytes[2];
+  memcpy(status->raw[block], r, sizeof(status->raw[block]));
+  status->valid|=1<<block;
+
+  if (block==VISCA_BLOCK_LENS)
+    {
+      status->zoom_value=(r[0]<<12)+(r[1]<<8)+(r[2]<<4)+r[3];
+      status->focus_near_limit=(r[4]<<12)+(r[5]<<8);
+      status->focus_value=(r[6]<<12)+(r[7]<<8)+(r[8]<<4)+r[9];
+      status->focus_auto=_VISCA_ONOFF(r[11], 0);
+      status->focus_auto_sense=_VISCA_ONOFF(r[11], 1);
+      status->dzoom=_VISCA_ONOFF(r[11], 2);
+      status->af_mode=(r[11]>>3)&0x03;
+      status->zooming=r[12]&0x01;
+      status->focusing=(r[12]>>1)&0x01;
+      status->memory_recall=(r[12]>>2)&0x01;
+    }
+  else if (block==VISCA_BLOCK_CAMERA)
+    {
+      status->rgain_value=(r[0]<<4)+r[1];
+      status->bgain_value=(r[2]<<4)+r[3];
+      status->whitebal_mode=r[4];
+      status->aperture_value=r[5];
+      status->auto_exp_mode=r[6];
+      status->slow_shutter=_VISCA_ONOFF(r[7], 0);
+      status->exp_comp_power=_VISCA_ONOFF(r[7], 1);
+      status->backlight_comp=_VISCA_ONOFF(r[7], 2);
+      status->shutter_value=r[8];
+      status->iris_value=r[9];
+      status->gain_value=r[10];
+      status->bright_value=r[11];
+      status->exp_comp_value=r[12];
+    }
+
+  return VISCA_SUCCESS;
 }
 
 
 uint32_t
-VISCA_set_at_mode_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
+VISCA_get_blocks(VISCAInterface_t *iface, VISCACamera_t *camera, VISCABlock_t *status)
 {
-  VISCAPacket_t packet;
+  uint32_t block, err;
 
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_MODE);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
+  // models without some of the blocks answer them with an Error, or
+  // with a shorter reply
+  status->valid=0;
+  err=VISCA_SUCCESS;
+  for (block=0; block<VISCA_BLOCKS; block++)
+    {
+      err=VISCA_get_block(iface, camera, block, status);
+      if ((err==VISCA_FAILURE)||(err==VISCA_TIMEOUT))
+	return err;
+    }
 
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return (status->valid!=0) ? VISCA_SUCCESS : err;
 }
 
 
+/********************************/
+/* SPECIAL FUNCTIONS FOR D30/31 */
+/********************************/
+
 uint32_t
-VISCA_set_at_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
+VISCA_set_wide_con_lens(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_wide_con_lens, power);
+}
 
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_MODE);
-  _VISCA_append_byte(&packet, power);
 
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+uint32_t
+VISCA_set_at_mode_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_mode_onoff);
 }
 
 
 uint32_t
-VISCA_set_at_ae_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
+VISCA_set_at_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_mode, power);
+}
 
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_AE);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
 
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+uint32_t
+VISCA_set_at_ae_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_ae_onoff);
 }
 
 
 uint32_t
 VISCA_set_at_ae(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_AE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_ae, power);
 }
 
 
 uint32_t
 VISCA_set_at_autozoom_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_AUTOZOOM);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_autozoom_onoff);
 }
 
 
 uint32_t
 VISCA_set_at_autozoom(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_AUTOZOOM);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_autozoom, power);
 }
 
 
 uint32_t
 VISCA_set_atmd_framedisplay_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_ATMD_FRAMEDISPLAY);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_atmd_framedisplay_onoff);
 }
 
 
 uint32_t
 VISCA_set_atmd_framedisplay(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_ATMD_FRAMEDISPLAY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_atmd_framedisplay, power);
 }
 
 
 uint32_t
 VISCA_set_at_frameoffset_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_FRAMEOFFSET);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_frameoffset_onoff);
 }
 
 
 uint32_t
 VISCA_set_at_frameoffset(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_FRAMEOFFSET);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_frameoffset, power);
 }
 
 
 uint32_t
 VISCA_set_atmd_startstop(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_ATMD_STARTSTOP);
-  _VISCA_append_byte(&packet, VISCA_AT_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_atmd_startstop);
 }
 
 
 uint32_t
 VISCA_set_at_chase(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_CHASE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_chase, power);
 }
 
 uint32_t
 VISCA_set_at_chase_next(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_CHASE);
-  _VISCA_append_byte(&packet, VISCA_AT_CHASE_NEXT);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_chase_next);
 }
 
 
 uint32_t
 VISCA_set_md_mode_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MODE);
-  _VISCA_append_byte(&packet, VISCA_MD_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_mode_onoff);
 }
 
 
 uint32_t
 VISCA_set_md_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MODE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_mode, power);
 }
 
 
 uint32_t
 VISCA_set_md_frame(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_FRAME);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_frame);
 }
 
 
 uint32_t
 VISCA_set_md_detect(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_DETECT);
-  _VISCA_append_byte(&packet, VISCA_MD_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_detect);
 }
 
 
 uint32_t
 VISCA_set_at_entry(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_AT_ENTRY);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_entry, power);
 }
 
 
 uint32_t
 VISCA_set_at_lostinfo(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_ATMD_LOSTINFO1);
-  _VISCA_append_byte(&packet, VISCA_ATMD_LOSTINFO2);
-  _VISCA_append_byte(&packet, VISCA_AT_LOSTINFO);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_at_lostinfo);
 }
 
 
 uint32_t
 VISCA_set_md_lostinfo(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_PAN_TILTER);
-  _VISCA_append_byte(&packet, VISCA_ATMD_LOSTINFO1);
-  _VISCA_append_byte(&packet, VISCA_ATMD_LOSTINFO2);
-  _VISCA_append_byte(&packet, VISCA_MD_LOSTINFO);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_lostinfo);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_ylevel(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_YLEVEL);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_ylevel, power);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_huelevel(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_HUELEVEL);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_huelevel, power);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_size(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_SIZE);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_size, power);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_disptime(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_DISPTIME);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_disptime, power);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_refmode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_REFMODE);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_refmode, power);
 }
 
 
 uint32_t
 VISCA_set_md_adjust_reftime(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST_REFTIME);
-  _VISCA_append_byte(&packet, VISCA_MD_ADJUST);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_adjust_reftime, power);
 }
 
 
 uint32_t
 VISCA_set_md_measure_mode1_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MEASURE_MODE_1);
-  _VISCA_append_byte(&packet, VISCA_MD_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_measure_mode1_onoff);
 }
 
 
 uint32_t
 VISCA_set_md_measure_mode1(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MEASURE_MODE_1);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_measure_mode1, power);
 }
 
 
 uint32_t
 VISCA_set_md_measure_mode2_onoff(VISCAInterface_t *iface, VISCACamera_t *camera)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MEASURE_MODE_2);
-  _VISCA_append_byte(&packet, VISCA_MD_ONOFF);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_measure_mode2_onoff);
 }
 
 
 uint32_t
 VISCA_set_md_measure_mode2(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power)
 {
-  VISCAPacket_t packet;
-
-  _VISCA_init_packet(&packet);
-  _VISCA_append_byte(&packet, VISCA_COMMAND);
-  _VISCA_append_byte(&packet, VISCA_CATEGORY_CAMERA2);
-  _VISCA_append_byte(&packet, VISCA_MD_MEASURE_MODE_2);
-  _VISCA_append_byte(&packet, power);
-
-  return _VISCA_send_packet_with_reply(iface, camera, &packet);
+  return _VISCA_send_template(iface, camera, &_VISCA_tmpl_set_md_measure_mode2, power);
 }
 
 
@@ -3335,7 +3825,7 @@ VISCA_get_keylock(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -3356,7 +3846,7 @@ VISCA_get_wide_con_lens(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -3377,7 +3867,7 @@ VISCA_get_atmd_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *pow
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -3398,7 +3888,7 @@ VISCA_get_at_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *valu
     return err;
   else
     {
-      *value=((iface->ibuf[2] & 0xff) << 8) + (iface->ibuf[3] & 0xff);
+      *value=((packet.bytes[2] & 0xff) << 8) + (packet.bytes[3] & 0xff);
       return VISCA_SUCCESS;
     }
 }
@@ -3419,7 +3909,7 @@ VISCA_get_at_entry(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *powe
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -3440,7 +3930,7 @@ VISCA_get_md_mode(VISCAInterface_t *iface, VISCACamera_t *camera, uint16_t *valu
     return err;
   else
     {
-      *value=((iface->ibuf[2] & 0xff) << 8) + (iface->ibuf[3] & 0xff);
+      *value=((packet.bytes[2] & 0xff) << 8) + (packet.bytes[3] & 0xff);
       return VISCA_SUCCESS;
     }
 }
@@ -3461,7 +3951,7 @@ VISCA_get_md_ylevel(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *pow
     return err;
   else
     {
-      *power=(iface->ibuf[3] & 0x0f);
+      *power=(packet.bytes[3] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3482,7 +3972,7 @@ VISCA_get_md_huelevel(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *p
     return err;
   else
     {
-      *power=(iface->ibuf[3] & 0x0f);
+      *power=(packet.bytes[3] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3503,7 +3993,7 @@ VISCA_get_md_size(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *power
     return err;
   else
     {
-      *power=(iface->ibuf[3] & 0x0f);
+      *power=(packet.bytes[3] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3524,7 +4014,7 @@ VISCA_get_md_disptime(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *p
     return err;
   else
     {
-      *power=(iface->ibuf[3] & 0x0f);
+      *power=(packet.bytes[3] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3545,7 +4035,7 @@ VISCA_get_md_refmode(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *po
     return err;
   else
     {
-      *power=iface->ibuf[2];
+      *power=packet.bytes[2];
       return VISCA_SUCCESS;
     }
 }
@@ -3566,7 +4056,7 @@ VISCA_get_md_reftime(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *po
     return err;
   else
     {
-      *power=(iface->ibuf[3] & 0x0f);
+      *power=(packet.bytes[3] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3588,9 +4078,9 @@ VISCA_get_at_obj_pos(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *xp
     return err;
   else
     {
-      *xpos=iface->ibuf[2];
-      *ypos=iface->ibuf[3];
-      *status=(iface->ibuf[4] & 0x0f);
+      *xpos=packet.bytes[2];
+      *ypos=packet.bytes[3];
+      *status=(packet.bytes[4] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -3611,9 +4101,9 @@ VISCA_get_md_obj_pos(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t *xp
     return err;
   else
     {
-      *xpos=iface->ibuf[2];
-      *ypos=iface->ibuf[3];
-      *status=(iface->ibuf[4] & 0x0f);
+      *xpos=packet.bytes[2];
+      *ypos=packet.bytes[3];
+      *status=(packet.bytes[4] & 0x0f);
       return VISCA_SUCCESS;
     }
 }
@@ -98,6 +98,7 @@
 #define   VISCA_ZOOM_WIDE                  0x03
 #define   VISCA_ZOOM_TELE_SPEED            0x20
 #define   VISCA_ZOOM_WIDE_SPEED            0x30
+#define   VISCA_ZOOM_SPEED_MAX             0x07
 #define VISCA_ZOOM_VALUE                 0x47
 #define VISCA_ZOOM_FOCUS_VALUE           0x47
 #define VISCA_DZOOM                      0x06
@@ -242,6 +243,8 @@
 #define   VISCA_PT_DRIVE_VERT_UP           0x01
 #define   VISCA_PT_DRIVE_VERT_DOWN         0x02
 #define   VISCA_PT_DRIVE_VERT_STOP         0x03
+#define   VISCA_PT_DRIVE_PAN_SPEED_MAX     0x18
+#define   VISCA_PT_DRIVE_TILT_SPEED_MAX    0x14
 #define VISCA_PT_ABSOLUTE_POSITION         0x02
 #define VISCA_PT_RELATIVE_POSITION         0x03
 #define VISCA_PT_HOME                      0x04
@@ -263,6 +266,21 @@
 #define VISCA_PT_DATASCREEN_INQ            0x06
 
 
+/******************/
+/* BLOCK INQUIRIES */
+/******************/
+
+/* 8x 09 7E 7E 0b FF: one reply carries a whole block of settings */
+#define VISCA_BLOCK_INQUIRY                0x7E
+
+#define VISCA_BLOCK_LENS                   0x00
+#define VISCA_BLOCK_CAMERA                 0x01
+#define VISCA_BLOCK_OTHER                  0x02
+#define VISCA_BLOCK_ENLARGEMENT            0x03
+
+#define VISCA_BLOCKS                       4
+
+
 /**************************/
 /* DIRECT REGISTER ACCESS */
 /**************************/
@@ -337,11 +355,14 @@
 /* ERROR CODES */
 /***************/
 
-/* these two are defined by me, not by the specs. */
+/* these are defined by me, not by the specs. */
 #define VISCA_SUCCESS                    0x00
 #define VISCA_FAILURE                    0xFF
+#define VISCA_TIMEOUT                    0xFE
+#define VISCA_SHORT_REPLY                0xFD  // a reply too short for what was asked
 
-/* specs errors: */
+/* specs errors: when the camera answers with an Error reply, functions
+ * return its error code. */
 #define VISCA_ERROR_MESSAGE_LENGTH       0x01
 #define VISCA_ERROR_SYNTAX               0x02
 #define VISCA_ERROR_CMD_BUFFER_FULL      0x03
@@ -349,6 +370,11 @@
 #define VISCA_ERROR_NO_SOCKET            0x05
 #define VISCA_ERROR_CMD_NOT_EXECUTABLE   0x41
 
+/* whether a command refused with this error may succeed if sent again
+ * later; other errors will not go away by retrying. */
+#define VISCA_ERROR_RETRYABLE(err) \
+  (((err)==VISCA_ERROR_CMD_BUFFER_FULL)||((err)==VISCA_ERROR_CMD_NOT_EXECUTABLE))
+
 /* Generic definitions */
 #define VISCA_ON                         0x02
 #define VISCA_OFF                        0x03
@@ -356,6 +382,12 @@
 #define VISCA_UP                         0x02
 #define VISCA_DOWN                       0x03
 
+/* serial line settings for VISCA_open_serial_ext(). VISCA itself uses
+ * 8 data bits, no parity, 1 stop bit and no flow control. */
+#define VISCA_SERIAL_DEFAULT             0x00
+#define VISCA_SERIAL_STOPB2              0x01
+#define VISCA_SERIAL_CRTSCTS             0x02
+
 /* response types */
 #define VISCA_RESPONSE_CLEAR             0x40
 #define VISCA_RESPONSE_ADDRESS           0x30
@@ -367,6 +399,54 @@
 extern "C" {
 #endif
 
+#ifndef __AVR__
+
+/* STATISTICS STRUCTURE -- counters kept by each interface, see
+ * VISCA_get_stats(). They are updated without locking and wrap around
+ * at 2^32.
+ */
+#define VISCA_STATS_ERRORS                  8
+#define VISCA_STATS_CATEGORIES              6
+#define VISCA_STATS_BUCKETS                24
+
+/* index in errors[] of an error code, 0 for unknown codes */
+#define VISCA_STATS_ERROR_INDEX(code) \
+  ((((code)>=VISCA_ERROR_MESSAGE_LENGTH)&&((code)<=VISCA_ERROR_NO_SOCKET)) ? (code) : \
+   ((code)==VISCA_ERROR_CMD_NOT_EXECUTABLE) ? 6 : 0)
+
+/* index in the latency tables of a category code: 1 interface, 2 camera 1,
+ * 3 pan/tilter, 4 camera 2, 5 block inquiries, 0 for other codes */
+#define VISCA_STATS_CATEGORY_INDEX(category) \
+  (((category)==VISCA_CATEGORY_INTERFACE) ? 1 : \
+   ((category)==VISCA_CATEGORY_CAMERA1) ? 2 : \
+   ((category)==VISCA_CATEGORY_PAN_TILTER) ? 3 : \
+   ((category)==VISCA_CATEGORY_CAMERA2) ? 4 : \
+   ((category)==VISCA_BLOCK_INQUIRY) ? 5 : 0)
+
+typedef struct _VISCA_stats
+{
+  uint32_t packets_sent;
+  uint32_t bytes_sent;
+  uint32_t packets_received;
+  uint32_t bytes_received;
+  uint32_t acks;
+  uint32_t acks_skipped;        // ACKs passed over by _VISCA_get_reply()
+  uint32_t completions;
+  uint32_t stray_replies;       // socket replies to no command in flight, dropped
+  uint32_t retries;             // commands sent again, see retry_max
+  uint32_t errors[VISCA_STATS_ERRORS]; // Error replies, by VISCA_STATS_ERROR_INDEX()
+  uint32_t timeouts;
+  uint32_t resyncs;             // broken packets dropped by the reader
+  uint32_t bytes_dropped;
+
+  // time from sending to the final reply, by VISCA_STATS_CATEGORY_INDEX():
+  // bucket b counts replies after 2^b to 2^(b+1) us
+  uint32_t command_latency[VISCA_STATS_CATEGORIES][VISCA_STATS_BUCKETS];
+  uint32_t inquiry_latency[VISCA_STATS_CATEGORIES][VISCA_STATS_BUCKETS];
+} VISCAStats_t;
+
+#endif
+
 #ifdef WIN
 
 #include <windows.h>
@@ -384,6 +464,14 @@ typedef struct _VISCA_interface
   // RS232 data:
   HANDLE port_fd;
   int baud;
+  uint32_t timeout; // reply timeout in us, unused: see COMMTIMEOUTS
+
+  // commands refused with VISCA_ERROR_CMD_BUFFER_FULL are sent again:
+  uint32_t retry_max;     // this many times at most, 0: never
+  uint32_t retry_backoff; // after this many us, doubling for each retry
+
+  struct _VISCA_cache *cache; // camera state cache, NULL: none
+  struct _VISCA_completion *completion; // how commands return, NULL: on their final reply
 
   // VISCA data:
   int address;
@@ -393,6 +481,16 @@ typedef struct _VISCA_interface
   unsigned char ibuf[VISCA_INPUT_BUFFER_SIZE];
   int bytes;
   int type;
+
+  // requests in flight, oldest first
+  struct _VISCA_request *requests;
+
+  // transport tags: of the last packet written, and of the one the reply
+  // in ibuf answers, 0: unknown
+  uint32_t write_tag;
+  uint32_t reply_tag;
+
+  VISCAStats_t stats;
 } VISCAInterface_t;
 
 typedef unsigned long  uint32_t;
@@ -415,6 +513,14 @@ typedef struct _VISCA_interface
 {
 	// RS232 data:
 	v24_port_t port_fd;
+	uint32_t timeout; // reply timeout in us, unused: see v24 timeouts
+
+	// commands refused with VISCA_ERROR_CMD_BUFFER_FULL are sent again:
+	uint32_t retry_max;     // this many times at most, 0: never
+	uint32_t retry_backoff; // after this many us, doubling for each retry
+
+	struct _VISCA_cache *cache; // camera state cache, NULL: none
+	struct _VISCA_completion *completion; // how commands return, NULL: on their final reply
 
 	// VISCA data:
 	int address;
@@ -424,27 +530,103 @@ typedef struct _VISCA_interface
 	unsigned char ibuf[VISCA_INPUT_BUFFER_SIZE];
 	int bytes;
 	int type;
+
+	// requests in flight, oldest first
+	struct _VISCA_request *requests;
+
+	// transport tags: of the last packet written, and of the one the reply
+	// in ibuf answers, 0: unknown
+	uint32_t write_tag;
+	uint32_t reply_tag;
 } VISCAInterface_t;
 
 #else
 
 #include <termios.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <sys/socket.h>
 
 /* timeout in us */
 #define VISCA_SERIAL_WAIT              100000
 
+/* VISCA over IP: each VISCA message travels in one UDP datagram behind an
+ * 8 byte header made of payload type, payload length and sequence number.
+ */
+#define VISCA_IP_PORT                   52381
+#define VISCA_IP_HEADER_SIZE                8
+#define VISCA_IP_COMMAND               0x0100
+#define VISCA_IP_INQUIRY               0x0110
+#define VISCA_IP_REPLY                 0x0111
+#define VISCA_IP_DEVICE_SETTING        0x0120
+#define VISCA_IP_CONTROL               0x0200
+#define VISCA_IP_CONTROL_REPLY         0x0201
+#define VISCA_IP_RESET                   0x01
+#define VISCA_IP_ERROR                   0x0F
+#define VISCA_IP_ERROR_SEQUENCE          0x01
+
+/* unanswered messages are sent again after this many us, this many times */
+#define VISCA_IP_RETRANSMIT_WAIT       100000
+#define VISCA_IP_RETRIES                    3
+
+/* messages waiting for their first reply (ACK, or Completion or Error of
+ * socket 0), at most */
+#define VISCA_IP_MESSAGES                  16
+
 /* size of the local packet buffer */
 #define VISCA_INPUT_BUFFER_SIZE          1024
 
+/* TRANSPORT STRUCTURE -- the operations behind an interface, chosen when
+ * it is opened. read_frame() leaves the next VISCA packet in iface->ibuf
+ * and iface->bytes. wait() returns once read_frame() has something to
+ * read. Timeouts are in us, 0 waits forever. Other transports, e.g. an
+ * in-memory one for tests, can be plugged in with VISCA_open_transport()
+ * and find their state in iface->transport_data, set before opening.
+ */
+struct _VISCA_interface;
+
+typedef struct _VISCA_transport
+{
+  const char *name;
+  uint32_t (*open)(struct _VISCA_interface *iface, const char *name);
+  uint32_t (*write)(struct _VISCA_interface *iface, const unsigned char *bytes, uint32_t length);
+  uint32_t (*read_frame)(struct _VISCA_interface *iface, uint32_t timeout);
+  uint32_t (*wait)(struct _VISCA_interface *iface, uint32_t timeout);
+  uint32_t (*close)(struct _VISCA_interface *iface);
+} VISCATransport_t;
+
+/* VISCA over IP message sent, until its first reply.
+ */
+typedef struct _VISCA_ip_message
+{
+  uint32_t tag;                 // given when first sent, 0: free slot
+  uint32_t seq;                 // sequence number it was last sent with
+  uint32_t retries;             // times it was sent again
+  uint32_t sent;                // time it was last sent, in us
+  uint32_t length;
+  unsigned char bytes[VISCA_IP_HEADER_SIZE+32];
+} VISCAIPMessage_t;
+
 /* This is the interface for the POSIX platform.
  */
 typedef struct _VISCA_interface
 {
+  // transport:
+  const struct _VISCA_transport *transport;
+  void *transport_data;
+
   // RS232 data:
   int port_fd;
   struct termios options;
   uint32_t baud;
+  uint32_t timeout; // reply timeout in us, 0 waits forever
+
+  // commands refused with VISCA_ERROR_CMD_BUFFER_FULL are sent again:
+  uint32_t retry_max;     // this many times at most, 0: never
+  uint32_t retry_backoff; // after this many us, doubling for each retry
+
+  struct _VISCA_cache *cache; // camera state cache, NULL: none
+  struct _VISCA_completion *completion; // how commands return, NULL: on their final reply
 
   // VISCA data:
   uint32_t address;
@@ -455,6 +637,37 @@ typedef struct _VISCA_interface
   uint32_t bytes;
   uint32_t type;
 
+  // RS232 receive ring buffer, holds bytes read ahead of the current packet
+  unsigned char rbuf[VISCA_INPUT_BUFFER_SIZE];
+  uint32_t rhead;
+  uint32_t rtail;
+
+  // requests in flight, oldest first
+  struct _VISCA_request *requests;
+
+  // transport tags: of the last packet written, and of the one the reply
+  // in ibuf answers, 0: unknown
+  uint32_t write_tag;
+  uint32_t reply_tag;
+
+  struct _VISCA_io *io; // non-blocking mode, see VISCA_io_init()
+
+  VISCAStats_t stats;
+
+  // VISCA over IP, see VISCA_udp_transport
+  pthread_mutex_t ip_lock;
+  uint32_t seq;          // sequence number of the last message sent
+  uint32_t ip_tags;      // tag of the last message sent
+  VISCAIPMessage_t ip_msg[VISCA_IP_MESSAGES]; // messages waiting for their first reply
+
+  // thread safe mode, see VISCA_start_reader()
+  pthread_mutex_t lock;
+  pthread_cond_t replied;
+  pthread_t reader;
+  uint32_t threaded;
+  uint32_t stopping;
+  uint32_t reader_err;
+
 } VISCAInterface_t;
 
 #endif
@@ -477,6 +690,10 @@ typedef struct _VISCA_camera
   uint32_t rom_version;
   uint32_t socket_num;
 
+  // last reply:
+  uint32_t last_error;          // its error code, VISCA_SUCCESS if none
+  uint32_t last_socket;         // socket it came from
+
 } VISCACamera_t;
 
 
@@ -491,17 +708,408 @@ typedef struct _VISCA_title
 
 } VISCATitleData_t;
 
+/* BLOCK STRUCTURE -- the settings returned by the block inquiries, see
+ * VISCA_get_blocks(). On/off settings are VISCA_ON or VISCA_OFF, the
+ * other ones are in the units of the matching VISCA_get_* function.
+ */
+typedef struct _VISCA_block
+{
+  uint32_t valid;               // bit b set if block b was read
+
+  // lens control block:
+  uint16_t zoom_value;
+  uint16_t focus_near_limit;
+  uint16_t focus_value;
+  uint8_t focus_auto;
+  uint8_t focus_auto_sense;     // VISCA_ON: normal, VISCA_OFF: low
+  uint8_t dzoom;
+  uint8_t af_mode;              // 0: normal, 1: interval, 2: zoom trigger
+  uint8_t zooming;              // 1 while the zoom moves
+  uint8_t focusing;             // 1 while the focus moves
+  uint8_t memory_recall;        // 1 while a memory is recalled
+
+  // camera control block:
+  uint16_t rgain_value;
+  uint16_t bgain_value;
+  uint8_t whitebal_mode;
+  uint16_t aperture_value;
+  uint8_t auto_exp_mode;
+  uint8_t slow_shutter;         // VISCA_ON: automatic
+  uint8_t exp_comp_power;
+  uint8_t backlight_comp;
+  uint16_t shutter_value;
+  uint16_t iris_value;
+  uint16_t gain_value;
+  uint16_t bright_value;
+  uint16_t exp_comp_value;
+
+  // the replies, header and terminator stripped, for the other blocks
+  // and the fields of models with another layout
+  unsigned char raw[VISCA_BLOCKS][13];
+} VISCABlock_t;
+
 typedef struct _VISCA_packet
 {
   unsigned char bytes[32];
   uint32_t length;
 } VISCAPacket_t;
 
+/* REQUEST STRUCTURE -- a command or inquiry followed from its sending to
+ * its final reply. It is allocated by the caller and linked into the
+ * interface while it is in flight.
+ */
+struct _VISCA_request;
+
+typedef void (*VISCARequestCallback_t)(struct _VISCA_request *req, void *data);
+
+typedef struct _VISCA_request
+{
+  VISCAPacket_t packet;         // packet to send
+  VISCAPacket_t reply;          // Completion or Error reply
+
+  uint32_t address;             // camera address
+  uint32_t state;               // one of VISCA_REQUEST_*
+  uint32_t socket;              // socket number given by the ACK
+  uint32_t error;               // error code of an Error reply
+  uint32_t sent;                // time it was sent, in us
+  uint32_t tag;                 // transport tag of its packet, see iface->reply_tag
+  struct _VISCA_drive *drive;   // drive it sends the commands of, NULL: none
+
+  VISCARequestCallback_t callback; // called once done, see VISCA_loop_submit()
+  void *data;
+
+  struct _VISCA_request *next;  // next request in flight or queued
+} VISCARequest_t;
+
+/* request states */
+#define VISCA_REQUEST_QUEUED             0x00
+#define VISCA_REQUEST_SENT               0x01
+#define VISCA_REQUEST_ACKED              0x02
+#define VISCA_REQUEST_DONE               0x03
+
+/* BUS STRUCTURE -- dispatches requests to the cameras of a daisy chain.
+ * Each camera address has its own queue, and up to 'window' requests per
+ * camera are in flight at the same time, so slow cameras do not hold up
+ * the others.
+ */
+typedef struct _VISCA_bus
+{
+  VISCAInterface_t *iface;
+  uint32_t window;                 // requests in flight per camera
+
+  struct _VISCA_request *queue[8]; // waiting requests, per camera address
+} VISCABus_t;
+
+/* BATCH STRUCTURE -- a list of commands sent in windowed bursts on a bus,
+ * e.g. to restore a full camera setup. Each command gets its own result.
+ */
+#define VISCA_BATCH_SIZE                   64
+
+typedef struct _VISCA_batch
+{
+  VISCABus_t bus;
+  uint32_t count;                                // commands in the batch
+
+  VISCACamera_t *camera[VISCA_BATCH_SIZE];       // camera of each command
+  VISCARequest_t request[VISCA_BATCH_SIZE];
+  uint32_t result[VISCA_BATCH_SIZE];             // result of each command
+} VISCABatch_t;
+
+/* DRIVE STRUCTURE -- continuous pan/tilt and zoom drive of one camera,
+ * e.g. from a joystick. Each channel has one drive command in flight at
+ * most. Newer drive vectors replace each other meanwhile instead of
+ * queuing up, and the newest one is sent from the reply path once the
+ * camera has answered.
+ */
+#define VISCA_DRIVE_PANTILT                0x00
+#define VISCA_DRIVE_ZOOM                   0x01
+
+typedef struct _VISCA_drive
+{
+  VISCAInterface_t *iface;
+  VISCACamera_t *camera;
+
+  VISCARequest_t request[2];    // drive command in flight, per VISCA_DRIVE_*
+  uint32_t pending[2];          // a newer drive vector waits in next[]
+  VISCAPacket_t next[2];        // newest drive vector not sent yet
+  uint32_t error[2];            // result of the last drive command finished
+
+  uint32_t sent;                // drive commands sent
+  uint32_t dropped;             // stale drive vectors never sent
+} VISCADrive_t;
+
+/* CACHE STRUCTURES -- the last replies to the inquiries of each camera,
+ * see VISCA_cache_init(). Each value is kept for the time to live of its
+ * field, given by the category and command bytes of the inquiry.
+ */
+#define VISCA_CACHE_ENTRIES                32
+#define VISCA_CACHE_FIELDS                 16
+
+/* cache entry states */
+#define VISCA_CACHE_EMPTY                0x00
+#define VISCA_CACHE_PENDING              0x01  // inquiry in flight
+#define VISCA_CACHE_VALID                0x02
+
+typedef struct _VISCA_cache_entry
+{
+  uint32_t state;               // one of VISCA_CACHE_*
+  uint32_t address;             // camera address
+  VISCAPacket_t inquiry;        // inquiry packet, without terminator
+  VISCAPacket_t reply;          // its last Completion
+  uint32_t time;                // time the reply came in, in us
+
+  struct _VISCA_request *request; // inquiry in flight, while pending
+} VISCACacheEntry_t;
+
+typedef struct _VISCA_cache_field
+{
+  uint32_t category;
+  uint32_t command;
+  uint32_t ttl;                 // time to live in us, 0: never cached
+} VISCACacheField_t;
+
+typedef struct _VISCA_cache
+{
+  uint32_t ttl;                 // time to live of the other fields, in us
+  uint32_t fields;
+  VISCACacheField_t field[VISCA_CACHE_FIELDS];
+
+  VISCACacheEntry_t entry[VISCA_CACHE_ENTRIES];
+
+  uint32_t hits;                // inquiries answered from the cache
+  uint32_t misses;              // inquiries sent to the camera
+  uint32_t merged;              // inquiries answered by an identical one in flight
+} VISCACache_t;
+
+/* COMPLETION STRUCTURES -- when the commands of an interface return, see
+ * VISCA_completion_init(). Commands that return before their final reply
+ * report it later as a result, through the callback or from
+ * VISCA_completion_get().
+ */
+#define VISCA_COMPLETION_REQUESTS           8
+#define VISCA_COMPLETION_RESULTS           16
+
+/* completion policies */
+#define VISCA_COMPLETION_WAIT            0x00  // return on Completion or Error
+#define VISCA_COMPLETION_ACK             0x01  // return on ACK
+#define VISCA_COMPLETION_NONE            0x02  // return once sent
+
+typedef struct _VISCA_result
+{
+  uint32_t address;             // camera address
+  uint32_t error;               // VISCA_SUCCESS, the error code of an Error reply, or VISCA_TIMEOUT
+  uint32_t socket;              // socket the command ran in
+  VISCAPacket_t command;        // command sent
+} VISCAResult_t;
+
+struct _VISCA_completion;
+
+typedef void (*VISCACompletionCallback_t)(struct _VISCA_completion *completion, VISCAResult_t *result, void *data);
+
+typedef struct _VISCA_completion
+{
+  uint32_t policy;                      // one of VISCA_COMPLETION_*
+  VISCACompletionCallback_t callback;   // NULL: results are queued
+  void *data;
+
+  VISCARequest_t request[VISCA_COMPLETION_REQUESTS]; // commands in flight
+  uint32_t held[VISCA_COMPLETION_REQUESTS];          // a caller still waits on it
+
+  VISCAResult_t result[VISCA_COMPLETION_RESULTS];    // queued results, oldest at head
+  uint32_t head;
+  uint32_t results;
+  uint32_t lost;                        // results dropped from a full queue
+} VISCACompletion_t;
+
+#if !defined(WIN) && !defined(__AVR__)
+
+/* SIMULATOR STRUCTURES -- a chain of simulated cameras, see
+ * VISCA_open_sim(). The model parameters can be changed after
+ * VISCA_sim_init().
+ */
+#define VISCA_SIM_REGISTERS                64
+#define VISCA_SIM_REPLIES                  64
+
+/* how the interface reaches the simulator */
+#define VISCA_SIM_DIRECT                 0x00  // in process, no system calls
+#define VISCA_SIM_SOCKETPAIR             0x01
+#define VISCA_SIM_PTY                    0x02
+#define VISCA_SIM_UDP                    0x03  // VISCA over IP on the loopback interface
+
+typedef struct _VISCA_sim_axis
+{
+  int32_t from;                 // position when the move started
+  int32_t to;                   // target position
+  uint32_t rate;                // positions per second
+  uint32_t start;               // time the move started, in us
+} VISCASimAxis_t;
+
+typedef struct _VISCA_sim_camera
+{
+  uint32_t power;
+  VISCASimAxis_t zoom;
+  VISCASimAxis_t focus;
+  VISCASimAxis_t pan;
+  VISCASimAxis_t tilt;
+
+  uint32_t socket_busy[2];      // command buffer
+  uint32_t socket_done[2];      // time the command in it completes
+
+  // other settings as last set: category, id, parameter count, parameters
+  uint32_t registers;
+  unsigned char reg[VISCA_SIM_REGISTERS][16];
+} VISCASimCamera_t;
+
+typedef struct _VISCA_sim_reply
+{
+  uint32_t due;                 // time it is sent, in us
+  uint32_t address;
+  uint32_t socket;              // socket of a Completion, 0 otherwise
+  uint32_t seq;                 // VISCA over IP sequence number it answers
+  unsigned char bytes[16];
+  uint32_t length;
+} VISCASimReply_t;
+
+typedef struct _VISCA_sim
+{
+  // model:
+  uint32_t cameras;             // cameras on the chain, 1 to 7
+  uint32_t model;               // model code of the camera info
+  uint32_t ack_delay;           // us from a command to its ACK
+  uint32_t completion_delay;    // us from the ACK to the Completion
+  uint32_t inquiry_delay;       // us from an inquiry to its reply
+  uint32_t zoom_rate;           // positions per second at top speed
+  uint32_t focus_rate;
+  uint32_t pan_rate;            // positions per second per speed step
+  uint32_t tilt_rate;
+  uint32_t drop;                // drop one in this many datagrams coming in over UDP, 0: none
+
+  // state:
+  VISCASimCamera_t camera[7];
+  VISCASimReply_t reply[VISCA_SIM_REPLIES]; // pending, by due time
+  uint32_t replies;
+  uint32_t packets;             // packets received
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+
+  // server thread of the socketpair, pty and UDP modes:
+  pthread_t server;
+  uint32_t running;
+  int fd;
+  int slave;
+  int wake[2];
+  unsigned char in[16];
+  uint32_t in_length;
+  char device_name[64];
+
+  // VISCA over IP:
+  uint32_t seq;                 // sequence number of the message being taken
+  uint32_t last_seq;            // highest sequence number taken since the reset
+  uint32_t datagrams;           // datagrams received
+  struct sockaddr_storage peer; // where replies go
+  socklen_t peer_length;
+} VISCASim_t;
+
+/* POLLER STRUCTURE -- a thread polling the positions of one camera for
+ * any number of subscribers, see VISCA_poller_start(). It polls every
+ * 'fast' us while a position changes, and slows down to every 'slow' us
+ * once they all stand still.
+ */
+#define VISCA_POLLER_SUBSCRIBERS           16
+
+/* polled positions */
+#define VISCA_POLL_ZOOM                  0x01
+#define VISCA_POLL_FOCUS                 0x02
+#define VISCA_POLL_PANTILT               0x04
+
+struct _VISCA_poller;
+
+/* called from the poller thread with the positions that changed. It may
+ * subscribe and unsubscribe, but must not stop or destroy the poller. */
+typedef void (*VISCAPollerCallback_t)(struct _VISCA_poller *poller, uint32_t changed, void *data);
+
+typedef struct _VISCA_poller_subscriber
+{
+  uint32_t positions;           // VISCA_POLL_* it is called for
+  VISCAPollerCallback_t callback;
+  void *data;
+  uint32_t first;               // positions whose first value is still due
+} VISCAPollerSubscriber_t;
+
+typedef struct _VISCA_poller
+{
+  VISCAInterface_t *iface;
+  VISCACamera_t camera;
+
+  uint32_t fast;                // poll interval while moving, in us
+  uint32_t slow;                // poll interval when idle, in us
+  uint32_t interval;            // current poll interval, in us
+
+  // last positions, valid for the VISCA_POLL_* set in 'valid'
+  uint32_t valid;
+  uint16_t zoom;
+  uint16_t focus;
+  int pan;
+  int tilt;
+
+  uint32_t polls;               // inquiries sent
+  uint32_t subscribers;
+  VISCAPollerSubscriber_t subscriber[VISCA_POLLER_SUBSCRIBERS];
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t called;        // signalled once the callbacks of a poll returned
+  pthread_t thread;
+  int running;
+  int kicked;
+  int calling;                  // the poller thread is calling the subscribers
+} VISCAPoller_t;
+
+/* NON-BLOCKING INTERFACE STRUCTURE -- runs the requests of an interface
+ * from an external event loop, see VISCA_io_init(). The interface is a
+ * bus, so its cameras are served side by side.
+ */
+#define VISCA_IO_READ                    0x01
+#define VISCA_IO_WRITE                   0x02
+
+typedef struct _VISCA_io
+{
+  VISCABus_t bus;                  // requests of the interface
+  uint32_t error;                  // port error that stopped it
+
+  // output buffer, holds bytes the port did not take yet
+  unsigned char obuf[VISCA_INPUT_BUFFER_SIZE];
+  uint32_t ohead;
+  uint32_t otail;
+} VISCAIO_t;
+
+#ifdef __linux__
+
+/* EVENT LOOP STRUCTURE -- serves the requests of many interfaces from a
+ * single thread, see VISCA_loop_init().
+ */
+#define VISCA_LOOP_INTERFACES              16
+
+typedef struct _VISCA_loop
+{
+  int epoll_fd;
+  uint32_t ports;                          // interfaces added
+  VISCAIO_t io[VISCA_LOOP_INTERFACES];     // one per interface
+  uint32_t events[VISCA_LOOP_INTERFACES];  // VISCA_IO_* events polled for
+} VISCALoop_t;
+
+#endif
+
+#endif
+
 /* GENERAL FUNCTIONS */
 
 uint32_t
 VISCA_open_serial(VISCAInterface_t *iface, const char *device_name);
 
+uint32_t
+VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags);
+
 uint32_t
 VISCA_close_serial(VISCAInterface_t *iface);
 
@@ -517,12 +1125,370 @@ VISCA_get_camera_info(VISCAInterface_t *iface, VISCACamera_t *camera);
 uint32_t
 _VISCA_write_packet_data(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
 
+void
+_VISCA_init_packet(VISCAPacket_t *packet);
+
+void
+_VISCA_append_byte(VISCAPacket_t *packet, unsigned char byte);
+
 uint32_t
 _VISCA_send_packet(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
 
 uint32_t
 _VISCA_get_packet(VISCAInterface_t *iface);
 
+uint32_t
+_VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout);
+
+void
+_VISCA_lock(VISCAInterface_t *iface);
+
+void
+_VISCA_unlock(VISCAInterface_t *iface);
+
+uint32_t
+_VISCA_get_time(void);
+
+uint32_t
+_VISCA_send_packet_with_reply_timeout(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet, uint32_t timeout);
+
+#ifndef __AVR__
+
+/* Copy the counters of the interface. */
+uint32_t
+VISCA_get_stats(VISCAInterface_t *iface, VISCAStats_t *stats);
+
+#endif
+
+/* ASYNCHRONOUS COMMANDS */
+
+/* Send the command in req->packet and return once the camera has
+ * acknowledged it. Up to two commands per camera can then be in flight
+ * at the same time. Returns the VISCA error code if the camera refused
+ * the command (e.g. VISCA_ERROR_CMD_BUFFER_FULL). */
+uint32_t
+VISCA_command_submit(VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req);
+
+/* Wait for the Completion or Error of a submitted command. Replies to
+ * other requests in flight are routed to them on the way. */
+uint32_t
+VISCA_command_wait(VISCAInterface_t *iface, VISCARequest_t *req);
+
+#if !defined(WIN) && !defined(__AVR__)
+
+/* TRANSPORTS */
+
+/* RS232 port at 9600 8N1, name is the device. */
+extern const VISCATransport_t VISCA_serial_transport;
+
+/* Serial-over-TCP bridge, name is "host:port". */
+extern const VISCATransport_t VISCA_tcp_transport;
+
+/* VISCA over IP camera, name is "host" or "host:port" (default
+ * VISCA_IP_PORT). The camera answers at address 1. */
+extern const VISCATransport_t VISCA_udp_transport;
+
+/* Open the interface on the given transport. Interfaces on different
+ * transports can be used side by side. */
+uint32_t
+VISCA_open_transport(VISCAInterface_t *iface, const VISCATransport_t *transport, const char *name);
+
+uint32_t
+VISCA_close_transport(VISCAInterface_t *iface);
+
+/* VISCA OVER IP */
+
+/* Open a UDP connection to a VISCA over IP camera on host:port (usually
+ * VISCA_IP_PORT) and reset its sequence number. The camera then answers
+ * at address 1. Close it with VISCA_close_serial(). */
+uint32_t
+VISCA_open_udp(VISCAInterface_t *iface, const char *host, uint32_t port);
+
+/* CAMERA SIMULATOR */
+
+/* Set up a chain of simulated cameras. They answer like real ones: ACK,
+ * Completion and Error replies after the configured delays, two command
+ * sockets per camera, zoom, focus and pan/tilt motors moving at their
+ * slew rates, and inquiries returning the current state. */
+void
+VISCA_sim_init(VISCASim_t *sim, uint32_t cameras);
+
+void
+VISCA_sim_destroy(VISCASim_t *sim);
+
+/* Open the interface on the simulator, in one of the VISCA_SIM_* modes.
+ * Close it with VISCA_close_serial(). */
+uint32_t
+VISCA_open_sim(VISCAInterface_t *iface, VISCASim_t *sim, uint32_t mode);
+
+/* Serve the simulator on a pseudo terminal, e.g. for another process.
+ * Its device name is written to device_name. */
+uint32_t
+VISCA_sim_start_pty(VISCASim_t *sim, char *device_name, uint32_t size);
+
+/* Serve the simulator as VISCA over IP cameras on the loopback interface,
+ * on the given UDP port (0: any free one, returned in *bound if not
+ * NULL). Replies carry the sequence number of the message they answer;
+ * a message numbered too far from the last one gets a sequence number
+ * error until the client resets the numbering. */
+uint32_t
+VISCA_sim_start_udp(VISCASim_t *sim, uint32_t port, uint32_t *bound);
+
+uint32_t
+VISCA_sim_stop(VISCASim_t *sim);
+
+/* THREAD SAFE MODE */
+
+/* Start a reader thread that routes every reply to the request waiting
+ * for it. Any number of threads can then call the VISCA_* functions on the
+ * interface at the same time, each getting its own reply. */
+uint32_t
+VISCA_start_reader(VISCAInterface_t *iface);
+
+uint32_t
+VISCA_stop_reader(VISCAInterface_t *iface);
+
+/* POSITION POLLER */
+
+/* Set up a poller for the camera, polling every 50 ms while moving and
+ * every second when idle. */
+void
+VISCA_poller_init(VISCAPoller_t *poller, VISCAInterface_t *iface, VISCACamera_t *camera);
+
+void
+VISCA_poller_destroy(VISCAPoller_t *poller);
+
+/* Have callback called with data whenever one of the given VISCA_POLL_*
+ * positions changes, and once with all of them after the first poll.
+ * Only the positions someone subscribed to are polled. Returns
+ * VISCA_FAILURE if there are too many subscribers. */
+uint32_t
+VISCA_poller_subscribe(VISCAPoller_t *poller, uint32_t positions, VISCAPollerCallback_t callback, void *data);
+
+/* Remove the subscriptions of callback with data. Once it returns, the
+ * callback is not called for them any more: called from another thread,
+ * it waits for a callback running meanwhile. Returns VISCA_FAILURE if
+ * there was no such subscription. */
+uint32_t
+VISCA_poller_unsubscribe(VISCAPoller_t *poller, VISCAPollerCallback_t callback, void *data);
+
+/* Start the poller thread. If other threads use the interface as well,
+ * start its reader thread first. */
+uint32_t
+VISCA_poller_start(VISCAPoller_t *poller);
+
+/* Poll at once and at the fast rate, e.g. after starting a movement. */
+void
+VISCA_poller_kick(VISCAPoller_t *poller);
+
+/* Stop the poller thread, waiting for it. Not from a callback. */
+uint32_t
+VISCA_poller_stop(VISCAPoller_t *poller);
+
+/* NON-BLOCKING INTERFACE */
+
+/* Switch the interface to non-blocking mode, up to two requests in
+ * flight per camera. Only interfaces on a byte stream (serial port, TCP
+ * bridge, simulator socket pair or pty) without reader thread can be
+ * switched, and they must not be used by other means until
+ * VISCA_io_destroy(). None of the VISCA_io_* functions block, and none
+ * are thread safe: call them from the thread running the event loop,
+ * e.g. from the request callbacks. */
+uint32_t
+VISCA_io_init(VISCAIO_t *io, VISCAInterface_t *iface);
+
+/* Switch back to blocking mode. The requests left fail with
+ * VISCA_FAILURE, their callbacks are called, and requests submitted
+ * from them fail too. */
+void
+VISCA_io_destroy(VISCAIO_t *io);
+
+/* Queue req->packet for the camera and send it as soon as the camera has
+ * a free slot. Once the request is done, callback (if not NULL) is
+ * called with it and data, its result in req->error: VISCA_SUCCESS, the
+ * error code of an Error reply, VISCA_TIMEOUT after iface->timeout
+ * without reply, or the port error. */
+uint32_t
+VISCA_io_submit(VISCAIO_t *io, VISCACamera_t *camera, VISCARequest_t *req, VISCARequestCallback_t callback, void *data);
+
+/* The file descriptor to watch, and the VISCA_IO_* events to watch it
+ * for. The events change as requests are submitted and processed. */
+int
+VISCA_io_fd(VISCAIO_t *io);
+
+uint32_t
+VISCA_io_events(VISCAIO_t *io);
+
+/* Time in us after which VISCA_io_process() must be called to time out
+ * unanswered requests, 0 if none can. */
+uint32_t
+VISCA_io_timeout(VISCAIO_t *io);
+
+/* Serve the VISCA_IO_* events the file descriptor is ready for (pass
+ * VISCA_IO_READ on errors and hang-ups as well), and time out unanswered
+ * requests. Callbacks fire from here. Returns the port error once the
+ * port failed, all requests then being finished with it. */
+uint32_t
+VISCA_io_process(VISCAIO_t *io, uint32_t events);
+
+/* Whether requests are queued or in flight. */
+uint32_t
+VISCA_io_busy(VISCAIO_t *io);
+
+#ifdef __linux__
+
+/* EVENT LOOP */
+
+/* Set up an empty event loop. Its functions are not thread safe: call
+ * them from one thread, e.g. from the request callbacks. */
+uint32_t
+VISCA_loop_init(VISCALoop_t *loop);
+
+/* Destroy the loop; each port is switched back as by VISCA_io_destroy(). */
+void
+VISCA_loop_destroy(VISCALoop_t *loop);
+
+/* Serve the interface from the loop, in non-blocking mode: see
+ * VISCA_io_init(). */
+uint32_t
+VISCA_loop_add(VISCALoop_t *loop, VISCAInterface_t *iface);
+
+/* Queue req->packet for the camera on the interface and return at once.
+ * Once the request is done, callback (if not NULL) is called with it
+ * and data, its result in req->error: VISCA_SUCCESS, the error code of
+ * an Error reply, VISCA_TIMEOUT after iface->timeout without reply, or
+ * the port error. */
+uint32_t
+VISCA_loop_submit(VISCALoop_t *loop, VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req, VISCARequestCallback_t callback, void *data);
+
+/* Wait at most timeout us (0: forever) for replies and serve them,
+ * firing the callbacks of the requests done. */
+uint32_t
+VISCA_loop_run_once(VISCALoop_t *loop, uint32_t timeout);
+
+/* Serve the interfaces until no request is queued or in flight. */
+uint32_t
+VISCA_loop_run(VISCALoop_t *loop);
+
+#endif
+
+#endif
+
+/* MULTI-CAMERA BUS */
+
+void
+VISCA_bus_init(VISCABus_t *bus, VISCAInterface_t *iface);
+
+/* Queue req->packet for the camera. It is sent as soon as the camera has
+ * a free slot in the window. */
+uint32_t
+VISCA_bus_submit(VISCABus_t *bus, VISCACamera_t *camera, VISCARequest_t *req);
+
+/* Wait for one reply, route it to its request and start the next queued
+ * request of that camera. Requests left unanswered for iface->timeout are
+ * finished with VISCA_TIMEOUT. */
+uint32_t
+VISCA_bus_process(VISCABus_t *bus);
+
+/* Process replies until req is done, and return its error code. */
+uint32_t
+VISCA_bus_wait(VISCABus_t *bus, VISCARequest_t *req);
+
+/* Process replies until every queue is empty. */
+uint32_t
+VISCA_bus_flush(VISCABus_t *bus);
+
+/* BATCHES */
+
+/* Start an empty batch. Up to two commands per camera, one per socket,
+ * are in flight at the same time; bus.window can be lowered before
+ * VISCA_batch_run(). */
+void
+VISCA_batch_init(VISCABatch_t *batch, VISCAInterface_t *iface);
+
+/* Append a copy of packet, built with _VISCA_init_packet() and
+ * _VISCA_append_byte(), for the camera. Returns VISCA_FAILURE if the
+ * batch is full. */
+uint32_t
+VISCA_batch_add(VISCABatch_t *batch, VISCACamera_t *camera, VISCAPacket_t *packet);
+
+/* Send every command of the batch and wait for their replies. The
+ * result of command i is left in batch->result[i]: VISCA_SUCCESS, the
+ * VISCA error code, VISCA_TIMEOUT or VISCA_FAILURE. Returns VISCA_SUCCESS
+ * if all of them succeeded, else the first result that did not. */
+uint32_t
+VISCA_batch_run(VISCABatch_t *batch);
+
+/* STATE CACHE */
+
+/* Start an empty cache whose values live ttl us. It is used once set in
+ * iface->cache: inquiries are then answered from it while their value
+ * lives, identical inquiries in flight at the same time go out once, and
+ * successful commands drop the values of their category, setting the
+ * value they give directly where its inquiry has the same bytes. */
+void
+VISCA_cache_init(VISCACache_t *cache, uint32_t ttl);
+
+/* Set the time to live of the values of the inquiry with the given
+ * category and command bytes, e.g. VISCA_CATEGORY_CAMERA1 and
+ * VISCA_ZOOM_VALUE. Returns VISCA_FAILURE if too many fields are set. */
+uint32_t
+VISCA_cache_set_ttl(VISCACache_t *cache, uint32_t category, uint32_t command, uint32_t ttl);
+
+/* Drop the cached values of the camera, e.g. when it was changed by its
+ * remote control. */
+void
+VISCA_cache_invalidate(VISCAInterface_t *iface, VISCACamera_t *camera);
+
+/* COMPLETION POLICY */
+
+/* Set up a completion policy, one of VISCA_COMPLETION_*. It applies to
+ * the commands of an interface once set in iface->completion; inquiries
+ * and broadcasts always wait for their reply. Under VISCA_COMPLETION_ACK
+ * a command returns when the camera has accepted it, with its socket in
+ * camera->last_socket, and under VISCA_COMPLETION_NONE as soon as it is
+ * sent. Its final reply is routed by the reader thread, or by the next
+ * call waiting for a reply, and reported through callback if not NULL,
+ * or else queued for VISCA_completion_get(). The callback runs with the
+ * interface locked and must not use the interface. Commands left
+ * unanswered for iface->timeout are reported with VISCA_TIMEOUT. Up to
+ * VISCA_COMPLETION_REQUESTS commands are in flight, more wait for one of
+ * them to finish. */
+void
+VISCA_completion_init(VISCACompletion_t *completion, uint32_t policy, VISCACompletionCallback_t callback, void *data);
+
+/* Take the oldest queued result. If there is none, route replies for at
+ * most timeout us (0: forever) until a command in flight finishes, and
+ * return VISCA_TIMEOUT if none did. Returns VISCA_FAILURE if no command
+ * is in flight. Without reader thread, this is also what delivers the
+ * results to the callback. */
+uint32_t
+VISCA_completion_get(VISCAInterface_t *iface, VISCAResult_t *result, uint32_t timeout);
+
+/* COALESCED DRIVE */
+
+/* The replies to the drive commands are routed by whatever reads the
+ * interface: the reader thread, VISCA_bus_process(), VISCA_io_process()
+ * or any other call waiting on it. The drive must stay around while its
+ * commands are in flight. */
+void
+VISCA_drive_init(VISCADrive_t *drive, VISCAInterface_t *iface, VISCACamera_t *camera);
+
+/* Drive pan/tilt at the given speeds, up to VISCA_PT_DRIVE_PAN_SPEED_MAX
+ * and VISCA_PT_DRIVE_TILT_SPEED_MAX: positive is right/up, negative is
+ * left/down, 0 stops the axis. Never waits for the camera: the vector is
+ * sent at once if no drive command is in flight on the channel, and
+ * left for the reply path to send otherwise, replacing (dropping) a
+ * vector left earlier. Returns the error of sending it, the result of
+ * the commands is kept in drive->error[]. */
+uint32_t
+VISCA_drive_pantilt(VISCADrive_t *drive, int pan_speed, int tilt_speed);
+
+/* Drive the zoom the same way, up to VISCA_ZOOM_SPEED_MAX: positive is
+ * tele, negative is wide, 0 stops. */
+uint32_t
+VISCA_drive_zoom(VISCADrive_t *drive, int speed);
+
 uint32_t
 VISCA_open_serial(VISCAInterface_t *iface, const char *device_name);
 
@@ -749,6 +1715,9 @@ VISCA_set_digital_effect(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t
 uint32_t
 VISCA_set_digital_effect_level(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t level);
 
+uint32_t
+VISCA_set_cam_stabilizer(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t power);
+
 uint32_t
 VISCA_memory_set(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t channel);
 
@@ -1124,6 +2093,19 @@ VISCA_set_register(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t reg_n
 uint32_t
 VISCA_get_register(VISCAInterface_t *iface, VISCACamera_t *camera, uint8_t reg_num, uint8_t* reg_val);
 
+/* Read one VISCA_BLOCK_* with a single inquiry. The lens and camera
+ * control blocks are decoded as laid out in the FCB-EX block inquiry
+ * list, the other ones are only kept raw. Returns VISCA_SHORT_REPLY if
+ * the reply is too short to hold a block. */
+uint32_t
+VISCA_get_block(VISCAInterface_t *iface, VISCACamera_t *camera, uint32_t block, VISCABlock_t *status);
+
+/* Read all blocks, in four round trips instead of one per setting.
+ * Blocks the camera does not know or answers too short are left out of
+ * status->valid. */
+uint32_t
+VISCA_get_blocks(VISCAInterface_t *iface, VISCACamera_t *camera, VISCABlock_t *status);
+
 
 #ifdef __cplusplus
 } /* closing brace for extern "C" */
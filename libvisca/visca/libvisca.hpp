@@ -0,0 +1,556 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __LIBVISCA_HPP__
+#define __LIBVISCA_HPP__
+
+/* C++20 coroutines over the non-blocking interfaces.
+ *
+ * Every command and inquiry of a visca::camera is awaitable from a
+ * visca::task:
+ *
+ *   visca::task<> track(visca::camera &cam)
+ *   {
+ *     co_await cam.zoom_to(0x2000);
+ *     auto [pan, tilt] = co_await cam.pantilt_position();
+ *     ...
+ *   }
+ *
+ *   visca::spawn(track(cam));
+ *   VISCA_loop_run(&loop);
+ *
+ * Awaiting submits the request to the VISCAIO_t or VISCALoop_t of the
+ * camera and suspends the coroutine; the request callback resumes it
+ * once the Completion or Error reply came, from the thread running the
+ * event loop. The request lives in the coroutine frame: nothing is
+ * allocated and no thread is started per request, so any number of
+ * coroutines can have requests in flight at once. A failed request
+ * throws a visca::error, as do the requests left when their VISCAIO_t
+ * or VISCALoop_t is destroyed, and those awaited after that: a
+ * coroutine is never left suspended for good.
+ */
+
+#include "libvisca.h"
+
+#if !defined(WIN) && !defined(__AVR__)
+
+#include <coroutine>
+#include <exception>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace visca {
+
+/* Result of a failed request: the error code of its Error reply,
+ * VISCA_TIMEOUT, or VISCA_FAILURE for a port error or a request that
+ * could not be submitted. */
+class error : public std::runtime_error
+{
+public:
+  explicit error(uint32_t code)
+    : std::runtime_error(describe(code)), code_(code) {}
+
+  uint32_t code() const noexcept { return code_; }
+
+private:
+  static std::string describe(uint32_t code)
+  {
+    switch (code)
+      {
+      case VISCA_ERROR_MESSAGE_LENGTH: return "VISCA: message length error";
+      case VISCA_ERROR_SYNTAX: return "VISCA: syntax error";
+      case VISCA_ERROR_CMD_BUFFER_FULL: return "VISCA: command buffer full";
+      case VISCA_ERROR_CMD_CANCELLED: return "VISCA: command cancelled";
+      case VISCA_ERROR_NO_SOCKET: return "VISCA: no socket";
+      case VISCA_ERROR_CMD_NOT_EXECUTABLE: return "VISCA: command not executable";
+      case VISCA_TIMEOUT: return "VISCA: no reply";
+      case VISCA_FAILURE: return "VISCA: port failure";
+      default: return "VISCA: error " + std::to_string(code);
+      }
+  }
+
+  uint32_t code_;
+};
+
+template<typename T = void> class task;
+
+namespace detail {
+
+struct promise_base
+{
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  // resume whoever awaits the task once it is done
+  struct final_awaiter
+  {
+    bool await_ready() const noexcept { return false; }
+
+    template<typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+    {
+      std::coroutine_handle<> next=handle.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception=std::current_exception(); }
+};
+
+template<typename T>
+struct promise : promise_base
+{
+  std::optional<T> value;
+
+  task<T> get_return_object() noexcept;
+  void return_value(T v) { value.emplace(std::move(v)); }
+
+  T result()
+  {
+    if (exception)
+      std::rethrow_exception(exception);
+    return std::move(*value);
+  }
+};
+
+template<>
+struct promise<void> : promise_base
+{
+  task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+
+  void result()
+  {
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+};
+
+} // namespace detail
+
+/* Lazily started coroutine returning a T: it runs once awaited, or once
+ * given to spawn(). */
+template<typename T>
+class task
+{
+public:
+  using promise_type = detail::promise<T>;
+
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+  task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+
+  ~task()
+  {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+  {
+    handle_.promise().continuation=caller;
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().result(); }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template<typename T>
+task<T> promise<T>::get_return_object() noexcept
+{
+  return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept
+{
+  return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+// coroutine owning itself, freed once done
+struct detached
+{
+  struct promise_type
+  {
+    detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+inline detached run_detached(task<void> t)
+{
+  co_await t;
+}
+
+} // namespace detail
+
+/* Start a task without awaiting it; it runs up to its first request,
+ * then on from the event loop. As with std::thread, an exception
+ * escaping it terminates the program. */
+inline void spawn(task<void> t)
+{
+  detail::run_detached(std::move(t));
+}
+
+class camera;
+
+namespace detail {
+
+/* A request to a camera, submitted when awaited. It stays in the
+ * awaiting coroutine's frame until its callback resumes it. This relies
+ * on every submitted request ending with its callback, VISCA_FAILURE
+ * when the port is destroyed: the frame must outlive the request. */
+class operation
+{
+public:
+  operation(camera *cam, std::initializer_list<unsigned char> bytes) noexcept
+    : cam_(cam), req_(), err_(VISCA_SUCCESS), submitting_(false), done_(false)
+  {
+    _VISCA_init_packet(&req_.packet);
+    for (unsigned char byte : bytes)
+      _VISCA_append_byte(&req_.packet, byte);
+  }
+
+  operation(const operation &) = delete;
+  operation &operator=(const operation &) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) noexcept;
+
+protected:
+  // the reply, or throw the error of the request
+  const VISCAPacket_t &reply() const
+  {
+    uint32_t err=(err_!=VISCA_SUCCESS) ? err_ : req_.error;
+
+    if (err!=VISCA_SUCCESS)
+      throw error(err);
+    return req_.reply;
+  }
+
+private:
+  static void resume(VISCARequest_t *, void *data) noexcept
+  {
+    operation *op=static_cast<operation *>(data);
+
+    // done before await_suspend() returned: do not suspend at all
+    if (op->submitting_)
+      op->done_=true;
+    else
+      op->handle_.resume();
+  }
+
+  camera *cam_;
+  VISCARequest_t req_;
+  std::coroutine_handle<> handle_;
+  uint32_t err_;
+  bool submitting_;
+  bool done_;
+};
+
+} // namespace detail
+
+/* Awaitable request whose reply is parsed into a T. */
+template<typename T>
+class request : public detail::operation
+{
+public:
+  using parser = T (*)(const VISCAPacket_t &reply);
+
+  request(camera *cam, parser parse, std::initializer_list<unsigned char> bytes) noexcept
+    : operation(cam, bytes), parse_(parse) {}
+
+  T await_resume() const { return parse_(reply()); }
+
+private:
+  parser parse_;
+};
+
+template<>
+class request<void> : public detail::operation
+{
+public:
+  request(camera *cam, std::initializer_list<unsigned char> bytes) noexcept
+    : operation(cam, bytes) {}
+
+  void await_resume() const { reply(); }
+};
+
+struct pantilt
+{
+  int pan;
+  int tilt;
+};
+
+/* A camera on an interface served by a VISCAIO_t, or by a VISCALoop_t
+ * on Linux. It can be shared by any number of coroutines, which must
+ * all run on the thread of the event loop. */
+class camera
+{
+public:
+  camera(VISCAIO_t *io, uint32_t address) noexcept
+    : io_(io), camera_()
+  {
+    camera_.address=address;
+  }
+
+#ifdef __linux__
+  camera(VISCALoop_t *loop, VISCAInterface_t *iface, uint32_t address) noexcept
+    : loop_(loop), iface_(iface), camera_()
+  {
+    camera_.address=address;
+  }
+#endif
+
+  uint32_t address() const noexcept { return camera_.address; }
+
+  /* Any command or inquiry, given from its category on: the rest of
+   * this class only names the common ones. inquiry() returns the whole
+   * Completion. A packet holds up to 16 bytes, header, VISCA_COMMAND or
+   * VISCA_INQUIRY and terminator included. */
+  template<typename... Bytes>
+  request<void> command(Bytes... bytes) noexcept
+  {
+    static_assert(sizeof...(Bytes)<=13, "VISCA packet too long");
+    return {this, {VISCA_COMMAND, (unsigned char)bytes...}};
+  }
+
+  template<typename... Bytes>
+  request<VISCAPacket_t> inquiry(Bytes... bytes) noexcept
+  {
+    static_assert(sizeof...(Bytes)<=13, "VISCA packet too long");
+    return {this, packet, {VISCA_INQUIRY, (unsigned char)bytes...}};
+  }
+
+  /* POWER */
+
+  request<void> set_power(bool on) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_POWER, (unsigned char)(on ? VISCA_ON : VISCA_OFF)}};
+  }
+
+  request<bool> power() noexcept
+  {
+    return {this, on, {VISCA_INQUIRY, VISCA_CATEGORY_CAMERA1, VISCA_POWER}};
+  }
+
+  /* ZOOM AND FOCUS */
+
+  request<void> zoom_to(uint16_t zoom) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM_VALUE,
+		   nibble(zoom, 12), nibble(zoom, 8), nibble(zoom, 4), nibble(zoom, 0)}};
+  }
+
+  // speed 0 (slow) to 7 (fast)
+  request<void> zoom_tele(uint8_t speed) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM,
+		   (unsigned char)(VISCA_ZOOM_TELE_SPEED|zoom_speed(speed))}};
+  }
+
+  request<void> zoom_wide(uint8_t speed) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM,
+		   (unsigned char)(VISCA_ZOOM_WIDE_SPEED|zoom_speed(speed))}};
+  }
+
+  request<void> zoom_stop() noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM, VISCA_ZOOM_STOP}};
+  }
+
+  request<uint16_t> zoom_position() noexcept
+  {
+    return {this, value16, {VISCA_INQUIRY, VISCA_CATEGORY_CAMERA1, VISCA_ZOOM_VALUE}};
+  }
+
+  request<void> focus_to(uint16_t focus) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_VALUE,
+		   nibble(focus, 12), nibble(focus, 8), nibble(focus, 4), nibble(focus, 0)}};
+  }
+
+  request<void> set_focus_auto(bool on) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_AUTO, (unsigned char)(on ? VISCA_ON : VISCA_OFF)}};
+  }
+
+  request<void> focus_one_push() noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_ONE_PUSH, 0x01}};
+  }
+
+  request<uint16_t> focus_position() noexcept
+  {
+    return {this, value16, {VISCA_INQUIRY, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_VALUE}};
+  }
+
+  /* PAN/TILT */
+
+  // move at the given speeds, their signs giving the direction (right
+  // and up are positive), 0 stopping the axis
+  request<void> pantilt_drive(int pan_speed, int tilt_speed) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_DRIVE,
+		   speed(pan_speed, VISCA_PT_DRIVE_PAN_SPEED_MAX),
+		   speed(tilt_speed, VISCA_PT_DRIVE_TILT_SPEED_MAX),
+		   (unsigned char)((pan_speed<0) ? VISCA_PT_DRIVE_HORIZ_LEFT :
+				   (pan_speed>0) ? VISCA_PT_DRIVE_HORIZ_RIGHT : VISCA_PT_DRIVE_HORIZ_STOP),
+		   (unsigned char)((tilt_speed>0) ? VISCA_PT_DRIVE_VERT_UP :
+				   (tilt_speed<0) ? VISCA_PT_DRIVE_VERT_DOWN : VISCA_PT_DRIVE_VERT_STOP)}};
+  }
+
+  request<void> pantilt_stop() noexcept
+  {
+    return pantilt_drive(0, 0);
+  }
+
+  request<void> pantilt_to(int pan, int tilt, uint8_t pan_speed=0x18, uint8_t tilt_speed=0x14) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_ABSOLUTE_POSITION,
+		   pan_speed, tilt_speed,
+		   nibble(pan, 16), nibble(pan, 12), nibble(pan, 8), nibble(pan, 4), nibble(pan, 0),
+		   nibble(tilt, 12), nibble(tilt, 8), nibble(tilt, 4), nibble(tilt, 0)}};
+  }
+
+  request<void> pantilt_by(int pan, int tilt, uint8_t pan_speed=0x18, uint8_t tilt_speed=0x14) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_RELATIVE_POSITION,
+		   pan_speed, tilt_speed,
+		   nibble(pan, 16), nibble(pan, 12), nibble(pan, 8), nibble(pan, 4), nibble(pan, 0),
+		   nibble(tilt, 12), nibble(tilt, 8), nibble(tilt, 4), nibble(tilt, 0)}};
+  }
+
+  request<void> pantilt_home() noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_HOME}};
+  }
+
+  request<pantilt> pantilt_position() noexcept
+  {
+    return {this, position, {VISCA_INQUIRY, VISCA_CATEGORY_PAN_TILTER, VISCA_PT_POSITION_INQ}};
+  }
+
+  /* MEMORY */
+
+  request<void> memory_set(uint8_t channel) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_MEMORY, VISCA_MEMORY_SET, channel}};
+  }
+
+  request<void> memory_recall(uint8_t channel) noexcept
+  {
+    return {this, {VISCA_COMMAND, VISCA_CATEGORY_CAMERA1, VISCA_MEMORY, VISCA_MEMORY_RECALL, channel}};
+  }
+
+private:
+  friend class detail::operation;
+
+  uint32_t submit(VISCARequest_t *req, VISCARequestCallback_t callback, void *data) noexcept
+  {
+#ifdef __linux__
+    if (loop_!=nullptr)
+      return VISCA_loop_submit(loop_, iface_, &camera_, req, callback, data);
+#endif
+    return VISCA_io_submit(io_, &camera_, req, callback, data);
+  }
+
+  static unsigned char nibble(uint32_t value, int shift) noexcept
+  {
+    return (value>>shift)&0xF;
+  }
+
+  // drive speed of a signed speed, clamped to 1..max
+  static unsigned char speed(int speed, int max) noexcept
+  {
+    if (speed<0)
+      speed=-speed;
+    return (speed>max) ? max : (speed>0) ? speed : 1;
+  }
+
+  static unsigned char zoom_speed(uint8_t speed) noexcept
+  {
+    return (speed>VISCA_ZOOM_SPEED_MAX) ? VISCA_ZOOM_SPEED_MAX : speed;
+  }
+
+  static VISCAPacket_t packet(const VISCAPacket_t &reply) { return reply; }
+
+  static bool on(const VISCAPacket_t &reply) { return reply.bytes[2]==VISCA_ON; }
+
+  static uint16_t value16(const VISCAPacket_t &reply)
+  {
+    return (reply.bytes[2]<<12)+(reply.bytes[3]<<8)+(reply.bytes[4]<<4)+reply.bytes[5];
+  }
+
+  static pantilt position(const VISCAPacket_t &reply)
+  {
+    uint16_t pan, tilt;
+
+    pan=((reply.bytes[3]&0xf)<<12)+((reply.bytes[4]&0xf)<<8)+((reply.bytes[5]&0xf)<<4)+(reply.bytes[6]&0xf);
+    tilt=((reply.bytes[7]&0xf)<<12)+((reply.bytes[8]&0xf)<<8)+((reply.bytes[9]&0xf)<<4)+(reply.bytes[10]&0xf);
+
+    return {reply.bytes[2] ? (int)pan-65536 : (int)pan,
+	    (tilt<0x8000) ? (int)tilt : (int)tilt-65536};
+  }
+
+  VISCAIO_t *io_=nullptr;
+#ifdef __linux__
+  VISCALoop_t *loop_=nullptr;
+  VISCAInterface_t *iface_=nullptr;
+#endif
+  VISCACamera_t camera_;
+};
+
+inline bool
+detail::operation::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+  handle_=handle;
+  submitting_=true;
+  err_=cam_->submit(&req_, resume, this);
+  submitting_=false;
+
+  // suspend until the callback, unless the request is over already
+  return (err_==VISCA_SUCCESS)&&!done_;
+}
+
+} // namespace visca
+
+#endif
+
+#endif
@@ -29,6 +29,10 @@
 #include "debugging.h"
 #include "libvisca.h"
 
+/* implemented in libvisca.c
+ */
+VISCARequest_t *_VISCA_dispatch_reply(VISCAInterface_t *iface);
+
 
 uint32_t
 _VISCA_write_packet_data(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet)
@@ -87,7 +91,7 @@ _VISCA_get_packet(VISCAInterface_t *iface)
 #ifdef DEBUG
 	dbg_ReportStrP(PSTR("_VISCA_get_packet: timeout\n"));
 #endif	
-	return VISCA_FAILURE;
+	return VISCA_TIMEOUT;
     }
     iface->ibuf[pos]=(BYTE)curr;
     while ( iface->ibuf[pos]!=VISCA_TERMINATOR )
@@ -116,10 +120,62 @@ _VISCA_get_packet(VISCAInterface_t *iface)
 
 
 
+/* There is no free running clock to rely on here, so deadlines never
+ * expire: timeouts are left to the v24 driver.
+ */
+uint32_t
+_VISCA_get_time(void)
+{
+    return 0;
+}
+
+
+
+/* Wait for the next reply and route it to its request.
+ */
+uint32_t
+_VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout)
+{
+    uint32_t err;
+
+    err=_VISCA_get_packet(iface);
+    if (err!=VISCA_SUCCESS)
+	 return err;
+    _VISCA_dispatch_reply(iface);
+
+    return VISCA_SUCCESS;
+}
+
+
+/* There is only one thread of control here, nothing to lock.
+ */
+void
+_VISCA_lock(VISCAInterface_t *iface)
+{
+}
+
+
+void
+_VISCA_unlock(VISCAInterface_t *iface)
+{
+}
+
+
+
 /***********************************/
 /*       SYSTEM  FUNCTIONS         */
 /***********************************/
 
+uint32_t
+VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags)
+{
+    /* The UART line settings are made by the application when it opens
+     * UART_VISCA, there is nothing to apply here.
+     */
+    return VISCA_open_serial(iface, device_name);
+}
+
+
 uint32_t
 VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
 {
@@ -137,6 +193,14 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
 
     iface->port_fd = UART_VISCA;
     iface->address=0;
+    iface->timeout=0;
+    iface->retry_max=0;
+    iface->retry_backoff=0;
+    iface->cache=NULL;
+    iface->completion=NULL;
+    iface->write_tag=0;
+    iface->reply_tag=0;
+    iface->requests=NULL;
 
     return VISCA_SUCCESS;
 }
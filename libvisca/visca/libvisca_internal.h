@@ -0,0 +1,42 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Private declarations shared by the platform independent code and the
+ * platform backends. Not installed.
+ */
+
+#ifndef __LIBVISCA_INTERNAL_H__
+#define __LIBVISCA_INTERNAL_H__
+
+/* Statistics are updated with relaxed atomic operations, as they are
+ * also updated from the reader thread and read without locking.
+ */
+#if defined(__AVR__)
+# define _VISCA_STAT_ADD(var, n)
+#elif defined(WIN)
+# define _VISCA_STAT_ADD(var, n) InterlockedExchangeAdd((LONG volatile *)&(var), (LONG)(n))
+# define _VISCA_STAT_GET(var)    InterlockedExchangeAdd((LONG volatile *)&(var), 0)
+#else
+# define _VISCA_STAT_ADD(var, n) __atomic_fetch_add(&(var), (n), __ATOMIC_RELAXED)
+# define _VISCA_STAT_GET(var)    __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#endif
+
+#endif /* __LIBVISCA_INTERNAL_H__ */
@@ -0,0 +1,378 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+
+/* Non-blocking interfaces for the POSIX platform.
+ *
+ * The requests of the interface are run as a bus whose requests advance
+ * as the port becomes readable or writable, so that an external event
+ * loop can drive it: the port is switched to non-blocking mode, packets
+ * to send go through an output buffer written as far as the port takes
+ * it, and what one read() returns is framed and routed to the requests
+ * it answers. No call waits for the port.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <libvisca.h>
+#include "libvisca_internal.h"
+
+
+/* implemented in libvisca.c and libvisca_posix.c
+ */
+VISCARequest_t *_VISCA_dispatch_reply(VISCAInterface_t *iface);
+void _VISCA_unlink_request(VISCAInterface_t *iface, VISCARequest_t *req);
+void _VISCA_bus_start(VISCABus_t *bus, VISCARequest_t **failed);
+unsigned int _VISCA_fd_receive(VISCAInterface_t *iface);
+unsigned int _VISCA_fd_frame(VISCAInterface_t *iface);
+unsigned int _VISCA_fd_read_frame(VISCAInterface_t *iface, uint32_t timeout);
+
+
+/* Write as much of the output buffer as the port takes.
+ */
+static uint32_t
+_VISCA_io_flush(VISCAIO_t *io)
+{
+  uint32_t head, length;
+  ssize_t ret;
+
+  while (io->ohead!=io->otail)
+    {
+      head=io->ohead%VISCA_INPUT_BUFFER_SIZE;
+      length=io->otail-io->ohead;
+      if (length>VISCA_INPUT_BUFFER_SIZE-head)
+	length=VISCA_INPUT_BUFFER_SIZE-head;
+
+      // a closed TCP bridge must not raise SIGPIPE
+      ret=send(io->bus.iface->port_fd, &io->obuf[head], length, MSG_NOSIGNAL);
+      if ((ret<0)&&(errno==ENOTSOCK))
+	ret=write(io->bus.iface->port_fd, &io->obuf[head], length);
+      if (ret<0)
+	{
+	  if (errno==EINTR)
+	    continue;
+	  if ((errno==EAGAIN)||(errno==EWOULDBLOCK))
+	    break;
+	  return VISCA_FAILURE;
+	}
+      io->ohead+=ret;
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+/* Send a packet through the output buffer, in place of the transport's
+ * write while the interface is in non-blocking mode.
+ */
+uint32_t
+_VISCA_io_write(VISCAIO_t *io, const unsigned char *bytes, uint32_t length)
+{
+  uint32_t i;
+
+  if (VISCA_INPUT_BUFFER_SIZE-(io->otail-io->ohead)<length)
+    return VISCA_FAILURE;
+
+  for (i=0;i<length;i++)
+    io->obuf[(io->otail+i)%VISCA_INPUT_BUFFER_SIZE]=bytes[i];
+  io->otail+=length;
+
+  return _VISCA_io_flush(io);
+}
+
+
+/* Fire the callbacks of a list of done requests. A callback may submit
+ * its request again, so the list is walked ahead of it.
+ */
+static void
+_VISCA_io_done(VISCARequest_t *done)
+{
+  VISCARequest_t *req;
+
+  while (done!=NULL)
+    {
+      req=done;
+      done=req->next;
+      req->next=NULL;
+      if (req->callback!=NULL)
+	req->callback(req,req->data);
+    }
+}
+
+
+/* Send what the window of each camera allows.
+ */
+static void
+_VISCA_io_start(VISCAIO_t *io)
+{
+  VISCARequest_t *failed=NULL;
+
+  if (io->error!=VISCA_SUCCESS)
+    return;
+
+  _VISCA_bus_start(&io->bus,&failed);
+  _VISCA_io_done(failed);
+}
+
+
+/* Stop on a port error, and finish the requests with it.
+ */
+static void
+_VISCA_io_fail(VISCAIO_t *io, uint32_t err)
+{
+  VISCAInterface_t *iface=io->bus.iface;
+  VISCARequest_t *done, *req, **tail;
+  uint32_t address;
+
+  io->error=err;
+  io->ohead=io->otail;
+
+  done=iface->requests;
+  iface->requests=NULL;
+  for (tail=&done; *tail!=NULL; tail=&(*tail)->next);
+  for (address=0;address<8;address++)
+    {
+      *tail=io->bus.queue[address];
+      io->bus.queue[address]=NULL;
+      for (; *tail!=NULL; tail=&(*tail)->next);
+    }
+
+  for (req=done; req!=NULL; req=req->next)
+    {
+      req->state=VISCA_REQUEST_DONE;
+      req->error=err;
+    }
+  _VISCA_io_done(done);
+}
+
+
+/* Read what the port has received and route every packet in it.
+ */
+static void
+_VISCA_io_read(VISCAIO_t *io)
+{
+  VISCAInterface_t *iface=io->bus.iface;
+  VISCARequest_t *req;
+  uint32_t err;
+
+  errno=0;
+  err=_VISCA_fd_receive(iface);
+  if (err!=VISCA_SUCCESS)
+    {
+      // nothing to read after all
+      if ((errno==EAGAIN)||(errno==EWOULDBLOCK))
+	return;
+      _VISCA_io_fail(io,err);
+      return;
+    }
+
+  while (_VISCA_fd_frame(iface)==VISCA_SUCCESS)
+    {
+      req=_VISCA_dispatch_reply(iface);
+      if ((req!=NULL)&&(req->state==VISCA_REQUEST_DONE)&&(req->callback!=NULL))
+	req->callback(req,req->data);
+    }
+
+  _VISCA_io_start(io);
+}
+
+
+/* Finish the requests left unanswered for iface->timeout with
+ * VISCA_TIMEOUT.
+ */
+static void
+_VISCA_io_expire(VISCAIO_t *io)
+{
+  VISCAInterface_t *iface=io->bus.iface;
+  VISCARequest_t *req, *next, *done=NULL;
+  uint32_t now;
+
+  if ((io->error!=VISCA_SUCCESS)||(iface->timeout==0))
+    return;
+
+  now=_VISCA_get_time();
+  for (req=iface->requests; req!=NULL; req=next)
+    {
+      next=req->next;
+      if (now-req->sent<iface->timeout)
+	continue;
+      _VISCA_unlink_request(iface,req);
+      req->state=VISCA_REQUEST_DONE;
+      req->error=VISCA_TIMEOUT;
+      _VISCA_STAT_ADD(iface->stats.timeouts, 1);
+      req->next=done;
+      done=req;
+    }
+
+  if (done!=NULL)
+    {
+      _VISCA_io_done(done);
+      _VISCA_io_start(io);
+    }
+}
+
+
+uint32_t
+VISCA_io_init(VISCAIO_t *io, VISCAInterface_t *iface)
+{
+  int flags;
+
+  if ((iface->transport->read_frame!=_VISCA_fd_read_frame)||iface->threaded||(iface->io!=NULL))
+    return VISCA_FAILURE;
+
+  flags=fcntl(iface->port_fd,F_GETFL);
+  if ((flags<0)||(fcntl(iface->port_fd,F_SETFL,flags|O_NONBLOCK)<0))
+    return VISCA_FAILURE;
+
+  VISCA_bus_init(&io->bus,iface);
+  io->bus.window=2;
+  io->error=VISCA_SUCCESS;
+  io->ohead=0;
+  io->otail=0;
+  iface->io=io;
+
+  return VISCA_SUCCESS;
+}
+
+
+void
+VISCA_io_destroy(VISCAIO_t *io)
+{
+  VISCAInterface_t *iface=io->bus.iface;
+  int flags;
+
+  flags=fcntl(iface->port_fd,F_GETFL);
+  if (flags>=0)
+    fcntl(iface->port_fd,F_SETFL,flags&~O_NONBLOCK);
+
+  // detached first, so that the callbacks see a blocking interface
+  iface->io=NULL;
+  _VISCA_io_fail(io,VISCA_FAILURE);
+}
+
+
+uint32_t
+VISCA_io_submit(VISCAIO_t *io, VISCACamera_t *camera, VISCARequest_t *req, VISCARequestCallback_t callback, void *data)
+{
+  VISCARequest_t **link;
+
+  if ((camera->address<1)||(camera->address>7))
+    return VISCA_FAILURE;
+  if (io->error!=VISCA_SUCCESS)
+    return io->error;
+
+  req->address=camera->address;
+  req->state=VISCA_REQUEST_QUEUED;
+  req->callback=callback;
+  req->data=data;
+  req->next=NULL;
+
+  for (link=&io->bus.queue[req->address]; *link!=NULL; link=&(*link)->next);
+  *link=req;
+  _VISCA_io_start(io);
+
+  return VISCA_SUCCESS;
+}
+
+
+int
+VISCA_io_fd(VISCAIO_t *io)
+{
+  return io->bus.iface->port_fd;
+}
+
+
+uint32_t
+VISCA_io_events(VISCAIO_t *io)
+{
+  if (io->error!=VISCA_SUCCESS)
+    return 0;
+
+  if (io->ohead!=io->otail)
+    return VISCA_IO_READ|VISCA_IO_WRITE;
+
+  return VISCA_IO_READ;
+}
+
+
+uint32_t
+VISCA_io_timeout(VISCAIO_t *io)
+{
+  VISCAInterface_t *iface=io->bus.iface;
+  VISCARequest_t *req;
+  uint32_t now, age, wait=0;
+
+  if ((io->error!=VISCA_SUCCESS)||(iface->timeout==0))
+    return 0;
+
+  now=_VISCA_get_time();
+  for (req=iface->requests; req!=NULL; req=req->next)
+    {
+      age=now-req->sent;
+      if (age>=iface->timeout)
+	return 1;
+      if ((wait==0)||(iface->timeout-age<wait))
+	wait=iface->timeout-age;
+    }
+
+  return wait;
+}
+
+
+uint32_t
+VISCA_io_process(VISCAIO_t *io, uint32_t events)
+{
+  uint32_t err;
+
+  if ((io->error==VISCA_SUCCESS)&&(events&VISCA_IO_WRITE))
+    {
+      err=_VISCA_io_flush(io);
+      if (err!=VISCA_SUCCESS)
+	_VISCA_io_fail(io,err);
+    }
+
+  if ((io->error==VISCA_SUCCESS)&&(events&VISCA_IO_READ))
+    _VISCA_io_read(io);
+
+  _VISCA_io_expire(io);
+
+  return io->error;
+}
+
+
+uint32_t
+VISCA_io_busy(VISCAIO_t *io)
+{
+  uint32_t address;
+
+  if (io->error!=VISCA_SUCCESS)
+    return 0;
+  if (io->bus.iface->requests!=NULL)
+    return 1;
+  for (address=0;address<8;address++)
+    if (io->bus.queue[address]!=NULL)
+      return 1;
+
+  return 0;
+}
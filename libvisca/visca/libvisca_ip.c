@@ -0,0 +1,523 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps 
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/* Network transports for the POSIX platform.
+ *
+ * The TCP transport talks to a serial-over-TCP bridge (terminal server),
+ * the byte stream is framed like that of a serial port.
+ *
+ * With the UDP transport, VISCA over IP, each VISCA message goes
+ * into one UDP datagram, behind an 8 byte header:
+ *
+ *   payload type (2) | payload length (2) | sequence number (4)
+ *
+ * all in network byte order. Replies carry the sequence number of the
+ * message they answer. Up to VISCA_IP_MESSAGES messages may wait for
+ * their first reply at once; each one is kept with its own sequence
+ * number and is sent again on its own when left unanswered. A sequence
+ * number error from the camera resets the numbering, and the waiting
+ * messages are then sent again under new numbers.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <libvisca.h>
+
+
+/* implemented in libvisca_posix.c
+ */
+unsigned int _VISCA_wait_input(VISCAInterface_t *iface, uint32_t timeout);
+unsigned int _VISCA_fd_read_frame(VISCAInterface_t *iface, uint32_t timeout);
+unsigned int _VISCA_fd_close(VISCAInterface_t *iface);
+
+
+/* Connect a socket of the given type to name, "host", "host:port" or
+ * "[ipv6 host]:port". port is used if name has none. Returns the socket,
+ * -1 on errors.
+ */
+static int
+_VISCA_ip_connect(const char *name, int socktype, uint32_t port)
+{
+  struct addrinfo hints, *res, *ai;
+  char host[256], service[16];
+  const char *colon, *end;
+  size_t len;
+  int fd=-1;
+
+  // split host and port
+  end=NULL;
+  if (name[0]=='[')
+    {
+      name++;
+      end=strchr(name, ']');
+      if (end==NULL)
+	return -1;
+      colon=(end[1]==':') ? end+1 : NULL;
+    }
+  else
+    {
+      colon=strrchr(name, ':');
+      if ((colon!=NULL)&&(strchr(name, ':')!=colon))
+	colon=NULL;   // bare IPv6 address
+      end=colon;
+    }
+  len=(end!=NULL) ? (size_t)(end-name) : strlen(name);
+  if (len>=sizeof(host))
+    return -1;
+  memcpy(host, name, len);
+  host[len]=0;
+  if (colon!=NULL)
+    snprintf(service, sizeof(service), "%s", colon+1);
+  else if (port!=0)
+    snprintf(service, sizeof(service), "%u", port);
+  else
+    return -1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family=AF_UNSPEC;
+  hints.ai_socktype=socktype;
+
+  if (getaddrinfo(host, service, &hints, &res)!=0)
+    {
+#if DEBUG
+      fprintf(stderr,"(%s): cannot resolve %s\n",__FILE__,host);
+#endif
+      return -1;
+    }
+
+  // with UDP, connect() makes only datagrams from the camera come in
+  for (ai=res; ai!=NULL; ai=ai->ai_next)
+    {
+      fd=socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd==-1)
+	continue;
+      if (connect(fd, ai->ai_addr, ai->ai_addrlen)==0)
+	break;
+      close(fd);
+      fd=-1;
+    }
+  freeaddrinfo(res);
+
+#if DEBUG
+  if (fd==-1)
+    fprintf(stderr,"(%s): cannot connect to %s:%s\n",__FILE__,host,service);
+#endif
+  return fd;
+}
+
+
+/***********************************/
+/*          TCP TRANSPORT          */
+/***********************************/
+
+static unsigned int
+_VISCA_tcp_open(VISCAInterface_t *iface, const char *name)
+{
+  int fd, on=1;
+
+  fd=_VISCA_ip_connect(name, SOCK_STREAM, 0);
+  if (fd==-1)
+    return VISCA_FAILURE;
+
+  // packets are small and latency matters
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  iface->port_fd=fd;
+
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_tcp_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length)
+{
+  ssize_t ret;
+
+  while (length>0)
+    {
+      // a closed bridge must not raise SIGPIPE
+      ret=send(iface->port_fd, bytes, length, MSG_NOSIGNAL);
+      if (ret<0)
+	{
+	  if (errno==EINTR)
+	    continue;
+	  return VISCA_FAILURE;
+	}
+      bytes+=ret;
+      length-=ret;
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+const VISCATransport_t VISCA_tcp_transport = {
+  "tcp",
+  _VISCA_tcp_open,
+  _VISCA_tcp_write,
+  _VISCA_fd_read_frame,
+  _VISCA_wait_input,
+  _VISCA_fd_close
+};
+
+
+/***********************************/
+/*          UDP TRANSPORT          */
+/***********************************/
+
+
+static void
+_VISCA_ip_header(unsigned char *header, uint32_t type, uint32_t length, uint32_t seq)
+{
+  header[0]=(type>>8)&0xFF;
+  header[1]=type&0xFF;
+  header[2]=(length>>8)&0xFF;
+  header[3]=length&0xFF;
+  header[4]=(seq>>24)&0xFF;
+  header[5]=(seq>>16)&0xFF;
+  header[6]=(seq>>8)&0xFF;
+  header[7]=seq&0xFF;
+}
+
+
+static uint32_t
+_VISCA_ip_send(VISCAInterface_t *iface, const unsigned char *msg, uint32_t length)
+{
+  ssize_t ret;
+
+  do {
+    ret=send(iface->port_fd, msg, length, 0);
+  } while ((ret<0)&&(errno==EINTR));
+
+  return (ret==(ssize_t)length) ? VISCA_SUCCESS : VISCA_FAILURE;
+}
+
+
+/* Ask the camera to reset its sequence number. Its control reply is not
+ * waited for here.
+ */
+static uint32_t
+_VISCA_ip_reset(VISCAInterface_t *iface)
+{
+  unsigned char msg[VISCA_IP_HEADER_SIZE+1];
+
+  iface->seq=0;
+  _VISCA_ip_header(msg, VISCA_IP_CONTROL, 1, iface->seq);
+  msg[VISCA_IP_HEADER_SIZE]=VISCA_IP_RESET;
+
+  return _VISCA_ip_send(iface, msg, sizeof(msg));
+}
+
+
+/* Send a message of iface->ip_msg, with the next sequence number if
+ * renumber is set. The caller holds iface->ip_lock.
+ */
+static uint32_t
+_VISCA_ip_transmit(VISCAInterface_t *iface, VISCAIPMessage_t *msg, uint32_t renumber)
+{
+  if (renumber)
+    {
+      iface->seq++;
+      msg->seq=iface->seq;
+      _VISCA_ip_header(msg->bytes, (msg->bytes[0]<<8)|msg->bytes[1],
+		       msg->length-VISCA_IP_HEADER_SIZE, msg->seq);
+    }
+  msg->sent=_VISCA_get_time();
+
+  return _VISCA_ip_send(iface, msg->bytes, msg->length);
+}
+
+
+/* After a reset, send the messages still waiting for their first reply
+ * again with new sequence numbers, oldest first. The caller holds
+ * iface->ip_lock.
+ */
+static void
+_VISCA_ip_renumber(VISCAInterface_t *iface)
+{
+  VISCAIPMessage_t *msg;
+  uint32_t i, done=0, oldest;
+
+  for (;;)
+    {
+      msg=NULL;
+      oldest=0;
+      for (i=0;i<VISCA_IP_MESSAGES;i++)
+	if ((iface->ip_msg[i].tag!=0)&&!(done&(1<<i))&&
+	    ((msg==NULL)||(iface->ip_tags-iface->ip_msg[i].tag>iface->ip_tags-msg->tag)))
+	  {
+	    msg=&iface->ip_msg[i];
+	    oldest=i;
+	  }
+      if (msg==NULL)
+	break;
+      done|=1<<oldest;
+      _VISCA_ip_transmit(iface, msg, 1);
+    }
+}
+
+
+unsigned int
+_VISCA_ip_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length)
+{
+  VISCAIPMessage_t *msg;
+  uint32_t type, err, i;
+
+  if ((length<2)||(length>sizeof(msg->bytes)-VISCA_IP_HEADER_SIZE))
+    return VISCA_FAILURE;
+
+  type=(bytes[1]==VISCA_INQUIRY) ? VISCA_IP_INQUIRY : VISCA_IP_COMMAND;
+
+  pthread_mutex_lock(&iface->ip_lock);
+
+  // take a free slot, or give up on the oldest message
+  msg=&iface->ip_msg[0];
+  for (i=0;i<VISCA_IP_MESSAGES;i++)
+    {
+      if (iface->ip_msg[i].tag==0)
+	{
+	  msg=&iface->ip_msg[i];
+	  break;
+	}
+      if (iface->ip_tags-iface->ip_msg[i].tag>iface->ip_tags-msg->tag)
+	msg=&iface->ip_msg[i];
+    }
+
+  iface->ip_tags++;
+  if (iface->ip_tags==0)
+    iface->ip_tags++;
+  msg->tag=iface->ip_tags;
+  msg->retries=0;
+  msg->length=VISCA_IP_HEADER_SIZE+length;
+  _VISCA_ip_header(msg->bytes, type, length, 0);
+  memcpy(&msg->bytes[VISCA_IP_HEADER_SIZE], bytes, length);
+
+  err=_VISCA_ip_transmit(iface, msg, 1);
+  if (err==VISCA_SUCCESS)
+    iface->write_tag=msg->tag;
+  else
+    msg->tag=0;
+
+  pthread_mutex_unlock(&iface->ip_lock);
+
+  return err;
+}
+
+
+/* Check a VISCA reply against the sequence numbers of the messages
+ * waiting for their first reply (their ACK, or the Completion or Error
+ * of socket 0), and leave the tag of the message it answers in
+ * iface->reply_tag. The first reply is only taken once: a message sent
+ * again may be answered twice. Completions and Errors on a socket
+ * answer earlier commands and always go through.
+ */
+static int
+_VISCA_ip_accept(VISCAInterface_t *iface, uint32_t seq, const unsigned char *payload, uint32_t length)
+{
+  uint32_t type, socket, i;
+  int ok=0;
+
+  if (length<3)
+    return 0;
+
+  type=payload[1]&0xF0;
+  socket=payload[1]&0x0F;
+  if ((type!=VISCA_RESPONSE_ACK)&&(socket!=0))
+    {
+      iface->reply_tag=0;
+      return 1;
+    }
+
+  pthread_mutex_lock(&iface->ip_lock);
+  for (i=0;i<VISCA_IP_MESSAGES;i++)
+    if ((iface->ip_msg[i].tag!=0)&&(iface->ip_msg[i].seq==seq))
+      {
+	iface->reply_tag=iface->ip_msg[i].tag;
+	iface->ip_msg[i].tag=0;
+	ok=1;
+	break;
+      }
+  pthread_mutex_unlock(&iface->ip_lock);
+
+  return ok;
+}
+
+
+unsigned int
+_VISCA_ip_read_frame(VISCAInterface_t *iface, uint32_t timeout)
+{
+  unsigned char buf[VISCA_IP_HEADER_SIZE+VISCA_INPUT_BUFFER_SIZE];
+  VISCAIPMessage_t *msg;
+  uint32_t start, now, wait, since, type, length, seq, err, i;
+  ssize_t ret;
+
+  start=_VISCA_get_time();
+
+  for (;;)
+    {
+      now=_VISCA_get_time();
+
+      // wait for what is left of timeout...
+      wait=0;
+      if (timeout>0)
+	{
+	  if (now-start>=timeout)
+	    return VISCA_TIMEOUT;
+	  wait=timeout-(now-start);
+	}
+
+      // ...but no longer than the next retransmission of an unanswered
+      // message, each on its own
+      pthread_mutex_lock(&iface->ip_lock);
+      for (i=0;i<VISCA_IP_MESSAGES;i++)
+	{
+	  msg=&iface->ip_msg[i];
+	  if ((msg->tag==0)||(msg->retries>=VISCA_IP_RETRIES))
+	    continue;
+	  since=now-msg->sent;
+	  if (since>=VISCA_IP_RETRANSMIT_WAIT)
+	    {
+	      msg->retries++;
+	      _VISCA_ip_transmit(iface, msg, 0);
+	      since=0;
+	    }
+	  if ((wait==0)||(wait>VISCA_IP_RETRANSMIT_WAIT-since))
+	    wait=VISCA_IP_RETRANSMIT_WAIT-since;
+	}
+      pthread_mutex_unlock(&iface->ip_lock);
+
+      err=_VISCA_wait_input(iface, wait);
+      if (err==VISCA_TIMEOUT)
+	continue;
+      if (err!=VISCA_SUCCESS)
+	return err;
+
+      ret=recv(iface->port_fd, buf, sizeof(buf), 0);
+      if (ret<0)
+	{
+	  if ((errno==EINTR)||(errno==EAGAIN))
+	    continue;
+	  return VISCA_FAILURE;
+	}
+      if (ret<VISCA_IP_HEADER_SIZE)
+	continue;
+
+      type=(buf[0]<<8)|buf[1];
+      length=(buf[2]<<8)|buf[3];
+      seq=((uint32_t)buf[4]<<24)|(buf[5]<<16)|(buf[6]<<8)|buf[7];
+      if (length!=(uint32_t)ret-VISCA_IP_HEADER_SIZE)
+	continue;
+
+      switch (type)
+	{
+	case VISCA_IP_REPLY:
+	  if (!_VISCA_ip_accept(iface, seq, &buf[VISCA_IP_HEADER_SIZE], length))
+	    break;
+	  memcpy(iface->ibuf, &buf[VISCA_IP_HEADER_SIZE], length);
+	  iface->bytes=length;
+	  return VISCA_SUCCESS;
+
+	case VISCA_IP_CONTROL_REPLY:
+	  // the camera lost track of the sequence numbers: start over
+	  if ((length>=2)&&(buf[VISCA_IP_HEADER_SIZE]==VISCA_IP_ERROR)&&
+	      (buf[VISCA_IP_HEADER_SIZE+1]==VISCA_IP_ERROR_SEQUENCE))
+	    {
+	      pthread_mutex_lock(&iface->ip_lock);
+	      _VISCA_ip_reset(iface);
+	      _VISCA_ip_renumber(iface);
+	      pthread_mutex_unlock(&iface->ip_lock);
+	    }
+	  break;
+	}
+    }
+}
+
+
+/* Connect and reset the sequence number, waiting for the camera to
+ * confirm it.
+ */
+unsigned int
+_VISCA_ip_open(VISCAInterface_t *iface, const char *name)
+{
+  unsigned char msg[VISCA_IP_HEADER_SIZE+VISCA_INPUT_BUFFER_SIZE];
+  int fd, tries;
+  ssize_t ret;
+
+  fd=_VISCA_ip_connect(name, SOCK_DGRAM, VISCA_IP_PORT);
+  if (fd==-1)
+    return VISCA_FAILURE;
+  iface->port_fd=fd;
+
+  for (tries=0; tries<=VISCA_IP_RETRIES; tries++)
+    {
+      if (_VISCA_ip_reset(iface)!=VISCA_SUCCESS)
+	break;
+      while (_VISCA_wait_input(iface, VISCA_IP_RETRANSMIT_WAIT)==VISCA_SUCCESS)
+	{
+	  ret=recv(fd, msg, sizeof(msg), 0);
+	  if ((ret==VISCA_IP_HEADER_SIZE+1)&&
+	      (((msg[0]<<8)|msg[1])==VISCA_IP_CONTROL_REPLY)&&
+	      (msg[VISCA_IP_HEADER_SIZE]==VISCA_IP_RESET))
+	    return VISCA_SUCCESS;
+	}
+    }
+
+#if DEBUG
+  fprintf(stderr,"(%s): no reply from %s\n",__FILE__,name);
+#endif
+  close(fd);
+  return VISCA_TIMEOUT;
+}
+
+
+const VISCATransport_t VISCA_udp_transport = {
+  "udp",
+  _VISCA_ip_open,
+  _VISCA_ip_write,
+  _VISCA_ip_read_frame,
+  _VISCA_wait_input,
+  _VISCA_fd_close
+};
+
+
+/***********************************/
+/*       SYSTEM  FUNCTIONS         */
+/***********************************/
+
+uint32_t
+VISCA_open_udp(VISCAInterface_t *iface, const char *host, uint32_t port)
+{
+  char name[300];
+
+  if (strchr(host, ':')!=NULL)
+    snprintf(name, sizeof(name), "[%s]:%u", host, port);
+  else
+    snprintf(name, sizeof(name), "%s:%u", host, port);
+
+  return VISCA_open_transport(iface, &VISCA_udp_transport, name);
+}
@@ -0,0 +1,202 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+
+/* Event loop for the Linux platform.
+ *
+ * A single thread serves the requests of many interfaces, each in
+ * non-blocking mode (see libvisca_io.c): epoll reports the ports that
+ * are ready, and the loop wakes up in time for the next request to run
+ * out. No call waits for a particular reply.
+ */
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <libvisca.h>
+
+
+static int
+_VISCA_loop_port(VISCALoop_t *loop, VISCAInterface_t *iface)
+{
+  uint32_t port;
+
+  for (port=0;port<loop->ports;port++)
+    if (loop->io[port].bus.iface==iface)
+      return (int)port;
+
+  return -1;
+}
+
+
+/* Have epoll watch the port for the events it now waits for, and drop it
+ * once it failed.
+ */
+static void
+_VISCA_loop_watch(VISCALoop_t *loop, uint32_t port)
+{
+  struct epoll_event event;
+  uint32_t events;
+
+  events=VISCA_io_events(&loop->io[port]);
+  if (events==loop->events[port])
+    return;
+
+  event.events=((events&VISCA_IO_READ) ? EPOLLIN : 0)|((events&VISCA_IO_WRITE) ? EPOLLOUT : 0);
+  event.data.u32=port;
+  epoll_ctl(loop->epoll_fd,(events==0) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD,
+	    VISCA_io_fd(&loop->io[port]),&event);
+  loop->events[port]=events;
+}
+
+
+uint32_t
+VISCA_loop_init(VISCALoop_t *loop)
+{
+  loop->epoll_fd=epoll_create1(EPOLL_CLOEXEC);
+  if (loop->epoll_fd<0)
+    return VISCA_FAILURE;
+
+  loop->ports=0;
+
+  return VISCA_SUCCESS;
+}
+
+
+void
+VISCA_loop_destroy(VISCALoop_t *loop)
+{
+  uint32_t port;
+
+  for (port=0;port<loop->ports;port++)
+    VISCA_io_destroy(&loop->io[port]);
+
+  close(loop->epoll_fd);
+  loop->epoll_fd=-1;
+  loop->ports=0;
+}
+
+
+uint32_t
+VISCA_loop_add(VISCALoop_t *loop, VISCAInterface_t *iface)
+{
+  struct epoll_event event;
+  uint32_t port=loop->ports;
+
+  if ((port>=VISCA_LOOP_INTERFACES)||(_VISCA_loop_port(loop,iface)>=0))
+    return VISCA_FAILURE;
+
+  if (VISCA_io_init(&loop->io[port],iface)!=VISCA_SUCCESS)
+    return VISCA_FAILURE;
+
+  event.events=EPOLLIN;
+  event.data.u32=port;
+  if (epoll_ctl(loop->epoll_fd,EPOLL_CTL_ADD,iface->port_fd,&event)<0)
+    {
+      VISCA_io_destroy(&loop->io[port]);
+      return VISCA_FAILURE;
+    }
+
+  loop->events[port]=VISCA_IO_READ;
+  loop->ports++;
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_loop_submit(VISCALoop_t *loop, VISCAInterface_t *iface, VISCACamera_t *camera, VISCARequest_t *req, VISCARequestCallback_t callback, void *data)
+{
+  uint32_t err;
+  int port;
+
+  port=_VISCA_loop_port(loop,iface);
+  if (port<0)
+    return VISCA_FAILURE;
+
+  err=VISCA_io_submit(&loop->io[port],camera,req,callback,data);
+  _VISCA_loop_watch(loop,(uint32_t)port);
+
+  return err;
+}
+
+
+uint32_t
+VISCA_loop_run_once(VISCALoop_t *loop, uint32_t timeout)
+{
+  struct epoll_event events[VISCA_LOOP_INTERFACES];
+  uint32_t port, wait, io_wait;
+  int n, i;
+
+  // wake up in time for the next request to run out
+  wait=timeout;
+  for (port=0;port<loop->ports;port++)
+    {
+      io_wait=VISCA_io_timeout(&loop->io[port]);
+      if ((io_wait!=0)&&((wait==0)||(io_wait<wait)))
+	wait=io_wait;
+    }
+
+  n=epoll_wait(loop->epoll_fd,events,VISCA_LOOP_INTERFACES,
+	       (wait==0) ? -1 : (int)((wait+999)/1000));
+  if ((n<0)&&(errno!=EINTR))
+    return VISCA_FAILURE;
+
+  for (i=0;i<n;i++)
+    VISCA_io_process(&loop->io[events[i].data.u32],
+		     ((events[i].events&EPOLLOUT) ? VISCA_IO_WRITE : 0)|
+		     ((events[i].events&(EPOLLIN|EPOLLERR|EPOLLHUP)) ? VISCA_IO_READ : 0));
+
+  // time out requests, and follow the events the callbacks caused
+  for (port=0;port<loop->ports;port++)
+    {
+      VISCA_io_process(&loop->io[port],0);
+      _VISCA_loop_watch(loop,port);
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_loop_run(VISCALoop_t *loop)
+{
+  uint32_t port, busy, err;
+
+  for (;;)
+    {
+      busy=0;
+      for (port=0;port<loop->ports;port++)
+	if (VISCA_io_busy(&loop->io[port]))
+	  busy=1;
+      if (!busy)
+	return VISCA_SUCCESS;
+
+      err=VISCA_loop_run_once(loop,0);
+      if (err!=VISCA_SUCCESS)
+	return err;
+    }
+}
+
+#endif
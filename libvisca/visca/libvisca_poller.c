@@ -0,0 +1,311 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+
+/* Position poller for the POSIX platform.
+ *
+ * One thread per camera polls the positions its subscribers are
+ * interested in, so the line carries the same inquiries however many
+ * parts of an application watch the camera. The poll interval drops to
+ * 'fast' whenever a position changed since the previous poll, and
+ * doubles up to 'slow' while none does.
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <libvisca.h>
+
+
+/* Poll the given positions, then update the poller under its lock.
+ * Returns the positions that changed.
+ */
+static uint32_t
+_VISCA_poller_poll(VISCAPoller_t *poller, uint32_t positions)
+{
+  VISCAInterface_t *iface=poller->iface;
+  uint32_t polled=0, changed=0;
+  uint16_t zoom=0, focus=0;
+  int pan=0, tilt=0;
+
+  if ((positions&VISCA_POLL_ZOOM)&&
+      (VISCA_get_zoom_value(iface,&poller->camera,&zoom)==VISCA_SUCCESS))
+    polled|=VISCA_POLL_ZOOM;
+  if ((positions&VISCA_POLL_FOCUS)&&
+      (VISCA_get_focus_value(iface,&poller->camera,&focus)==VISCA_SUCCESS))
+    polled|=VISCA_POLL_FOCUS;
+  if ((positions&VISCA_POLL_PANTILT)&&
+      (VISCA_get_pantilt_position(iface,&poller->camera,&pan,&tilt)==VISCA_SUCCESS))
+    polled|=VISCA_POLL_PANTILT;
+
+  pthread_mutex_lock(&poller->lock);
+  if (positions&VISCA_POLL_ZOOM)
+    poller->polls++;
+  if (positions&VISCA_POLL_FOCUS)
+    poller->polls++;
+  if (positions&VISCA_POLL_PANTILT)
+    poller->polls++;
+
+  if ((polled&VISCA_POLL_ZOOM)&&
+      (!(poller->valid&VISCA_POLL_ZOOM)||(poller->zoom!=zoom)))
+    {
+      poller->zoom=zoom;
+      changed|=VISCA_POLL_ZOOM;
+    }
+  if ((polled&VISCA_POLL_FOCUS)&&
+      (!(poller->valid&VISCA_POLL_FOCUS)||(poller->focus!=focus)))
+    {
+      poller->focus=focus;
+      changed|=VISCA_POLL_FOCUS;
+    }
+  if ((polled&VISCA_POLL_PANTILT)&&
+      (!(poller->valid&VISCA_POLL_PANTILT)||(poller->pan!=pan)||(poller->tilt!=tilt)))
+    {
+      poller->pan=pan;
+      poller->tilt=tilt;
+      changed|=VISCA_POLL_PANTILT;
+    }
+
+  // a first value is no movement
+  if (changed&poller->valid)
+    poller->interval=poller->fast;
+  else if (poller->interval<poller->slow)
+    poller->interval=(poller->interval*2<poller->slow) ? poller->interval*2 : poller->slow;
+  poller->valid|=polled;
+  pthread_mutex_unlock(&poller->lock);
+
+  return changed;
+}
+
+
+/* Whether the subscriber copied for a callback is still subscribed, it
+ * may have been unsubscribed by an earlier callback or another thread.
+ */
+static int
+_VISCA_poller_subscribed(VISCAPoller_t *poller, VISCAPollerSubscriber_t *subscriber)
+{
+  uint32_t i;
+  int found=0;
+
+  pthread_mutex_lock(&poller->lock);
+  for (i=0;(i<poller->subscribers)&&!found;i++)
+    found=(poller->subscriber[i].callback==subscriber->callback)&&
+      (poller->subscriber[i].data==subscriber->data);
+  pthread_mutex_unlock(&poller->lock);
+
+  return found;
+}
+
+
+static void *
+_VISCA_poller(void *arg)
+{
+  VISCAPoller_t *poller=(VISCAPoller_t *)arg;
+  VISCAPollerSubscriber_t subscriber[VISCA_POLLER_SUBSCRIBERS];
+  uint32_t report[VISCA_POLLER_SUBSCRIBERS];
+  struct timespec ts;
+  uint32_t positions, changed, subscribers, i;
+
+  pthread_mutex_lock(&poller->lock);
+  while (poller->running)
+    {
+      positions=0;
+      for (i=0;i<poller->subscribers;i++)
+	positions|=poller->subscriber[i].positions;
+      poller->kicked=0;
+      pthread_mutex_unlock(&poller->lock);
+
+      changed=_VISCA_poller_poll(poller,positions);
+
+      // call the subscribers without the lock, they may subscribe others
+      pthread_mutex_lock(&poller->lock);
+      subscribers=poller->subscribers;
+      for (i=0;i<subscribers;i++)
+	{
+	  subscriber[i]=poller->subscriber[i];
+	  report[i]=(subscriber[i].positions&changed)|(subscriber[i].first&poller->valid);
+	  poller->subscriber[i].first&=~poller->valid;
+	}
+      poller->calling=1;
+      pthread_mutex_unlock(&poller->lock);
+      for (i=0;i<subscribers;i++)
+	if (report[i]&&_VISCA_poller_subscribed(poller,&subscriber[i]))
+	  subscriber[i].callback(poller,report[i],subscriber[i].data);
+
+      pthread_mutex_lock(&poller->lock);
+      poller->calling=0;
+      pthread_cond_broadcast(&poller->called);
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      ts.tv_sec+=poller->interval/1000000;
+      ts.tv_nsec+=(long)(poller->interval%1000000)*1000;
+      if (ts.tv_nsec>=1000000000)
+	{
+	  ts.tv_sec++;
+	  ts.tv_nsec-=1000000000;
+	}
+      while (poller->running&&!poller->kicked)
+	if (pthread_cond_timedwait(&poller->wake, &poller->lock, &ts)==ETIMEDOUT)
+	  break;
+    }
+  pthread_mutex_unlock(&poller->lock);
+
+  return NULL;
+}
+
+
+void
+VISCA_poller_init(VISCAPoller_t *poller, VISCAInterface_t *iface, VISCACamera_t *camera)
+{
+  pthread_condattr_t cattr;
+
+  poller->iface=iface;
+  poller->camera=*camera;
+  poller->fast=50000;
+  poller->slow=1000000;
+  poller->interval=poller->fast;
+  poller->valid=0;
+  poller->polls=0;
+  poller->subscribers=0;
+  poller->running=0;
+  poller->kicked=0;
+  poller->calling=0;
+
+  pthread_mutex_init(&poller->lock, NULL);
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+  pthread_cond_init(&poller->wake, &cattr);
+  pthread_cond_init(&poller->called, NULL);
+  pthread_condattr_destroy(&cattr);
+}
+
+
+void
+VISCA_poller_destroy(VISCAPoller_t *poller)
+{
+  VISCA_poller_stop(poller);
+  pthread_cond_destroy(&poller->wake);
+  pthread_cond_destroy(&poller->called);
+  pthread_mutex_destroy(&poller->lock);
+}
+
+
+uint32_t
+VISCA_poller_subscribe(VISCAPoller_t *poller, uint32_t positions, VISCAPollerCallback_t callback, void *data)
+{
+  VISCAPollerSubscriber_t *subscriber;
+
+  pthread_mutex_lock(&poller->lock);
+  if (poller->subscribers>=VISCA_POLLER_SUBSCRIBERS)
+    {
+      pthread_mutex_unlock(&poller->lock);
+      return VISCA_FAILURE;
+    }
+  subscriber=&poller->subscriber[poller->subscribers++];
+  subscriber->positions=positions;
+  subscriber->callback=callback;
+  subscriber->data=data;
+  subscriber->first=positions;
+
+  poller->kicked=1;
+  pthread_cond_signal(&poller->wake);
+  pthread_mutex_unlock(&poller->lock);
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_poller_unsubscribe(VISCAPoller_t *poller, VISCAPollerCallback_t callback, void *data)
+{
+  uint32_t i, j;
+
+  pthread_mutex_lock(&poller->lock);
+  for (i=0,j=0;i<poller->subscribers;i++)
+    if ((poller->subscriber[i].callback!=callback)||(poller->subscriber[i].data!=data))
+      poller->subscriber[j++]=poller->subscriber[i];
+  if (j==poller->subscribers)
+    {
+      pthread_mutex_unlock(&poller->lock);
+      return VISCA_FAILURE;
+    }
+  poller->subscribers=j;
+
+  // a callback may be running with it: wait for it, unless it is the caller
+  while (poller->calling&&!pthread_equal(pthread_self(),poller->thread))
+    pthread_cond_wait(&poller->called, &poller->lock);
+  pthread_mutex_unlock(&poller->lock);
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_poller_start(VISCAPoller_t *poller)
+{
+  pthread_mutex_lock(&poller->lock);
+  if (poller->running)
+    {
+      pthread_mutex_unlock(&poller->lock);
+      return VISCA_FAILURE;
+    }
+  poller->running=1;
+  poller->interval=poller->fast;
+  if (pthread_create(&poller->thread, NULL, _VISCA_poller, poller)!=0)
+    {
+      poller->running=0;
+      pthread_mutex_unlock(&poller->lock);
+      return VISCA_FAILURE;
+    }
+  pthread_mutex_unlock(&poller->lock);
+
+  return VISCA_SUCCESS;
+}
+
+
+void
+VISCA_poller_kick(VISCAPoller_t *poller)
+{
+  pthread_mutex_lock(&poller->lock);
+  poller->interval=poller->fast;
+  poller->kicked=1;
+  pthread_cond_signal(&poller->wake);
+  pthread_mutex_unlock(&poller->lock);
+}
+
+
+uint32_t
+VISCA_poller_stop(VISCAPoller_t *poller)
+{
+  pthread_mutex_lock(&poller->lock);
+  if (!poller->running)
+    {
+      pthread_mutex_unlock(&poller->lock);
+      return VISCA_FAILURE;
+    }
+  poller->running=0;
+  pthread_cond_signal(&poller->wake);
+  pthread_mutex_unlock(&poller->lock);
+
+  pthread_join(poller->thread, NULL);
+
+  return VISCA_SUCCESS;
+}
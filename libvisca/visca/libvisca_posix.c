@@ -25,8 +25,12 @@
 #include <errno.h>
 #include <termios.h>
 #include <unistd.h>
-#include <sys/ioctl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <pthread.h>
 #include <libvisca.h>
+#include "libvisca_internal.h"
 
 
 
@@ -37,6 +41,12 @@ void _VISCA_append_byte(VISCAPacket_t *packet, unsigned char byte);
 void _VISCA_init_packet(VISCAPacket_t *packet);
 unsigned int _VISCA_get_reply(VISCAInterface_t *iface, VISCACamera_t *camera);
 unsigned int _VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
+VISCARequest_t *_VISCA_dispatch_reply(VISCAInterface_t *iface);
+
+/* implemented in libvisca_io.c
+ */
+uint32_t _VISCA_io_write(VISCAIO_t *io, const unsigned char *bytes, uint32_t length);
+
 
 
 
@@ -46,22 +56,26 @@ unsigned int _VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_
  * unsigned int _VISCA_write_packet_data(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
  * unsigned int _VISCA_send_packet(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
  * unsigned int _VISCA_get_packet(VISCAInterface_t *iface);
+ * unsigned int _VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout);
+ * void _VISCA_lock(VISCAInterface_t *iface);
+ * void _VISCA_unlock(VISCAInterface_t *iface);
+ * uint32_t _VISCA_get_time(void);
  * unsigned int VISCA_open_serial(VISCAInterface_t *iface, const char *device_name);
+ * unsigned int VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags);
  * unsigned int VISCA_close_serial(VISCAInterface_t *iface);
- * 
+ *
+ * The reading and writing itself goes through iface->transport. The
+ * serial transport is implemented here, the network ones in libvisca_ip.c.
  */
 
 
 unsigned int
 _VISCA_write_packet_data(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet)
 {
-    int err;
+    if (iface->io!=NULL)
+	return _VISCA_io_write(iface->io, packet->bytes, packet->length);
 
-    err = write(iface->port_fd, packet->bytes, packet->length);
-    if ( err < packet->length )
-	return VISCA_FAILURE;
-    else
-	return VISCA_SUCCESS;
+    return iface->transport->write(iface, packet->bytes, packet->length);
 }
 
 
@@ -97,41 +111,522 @@ _VISCA_send_packet(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t
 }
 
 
+/***********************************/
+/*      FILE DESCRIPTOR I/O        */
+/***********************************/
+
+/* Transport operations shared by the transports working on a byte stream
+ * file descriptor in iface->port_fd.
+ */
+
+unsigned int
+_VISCA_fd_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length)
+{
+    ssize_t ret;
+
+    while (length>0) {
+	ret=write(iface->port_fd, bytes, length);
+	if (ret<0) {
+	    if (errno==EINTR)
+		continue;
+	    return VISCA_FAILURE;
+	}
+	bytes+=ret;
+	length-=ret;
+    }
+
+    return VISCA_SUCCESS;
+}
+
+
+unsigned int
+_VISCA_fd_close(VISCAInterface_t *iface)
+{
+    return (close(iface->port_fd)==0) ? VISCA_SUCCESS : VISCA_FAILURE;
+}
+
+
+/* Block in poll() until the port becomes readable. timeout is given in
+ * us, 0 waits forever. Returns VISCA_TIMEOUT if nothing arrived in time
+ * and VISCA_FAILURE on port errors.
+ */
+unsigned int
+_VISCA_wait_input(VISCAInterface_t *iface, uint32_t timeout)
+{
+    struct pollfd pfd;
+    int ret;
+
+    pfd.fd=iface->port_fd;
+    pfd.events=POLLIN;
+    pfd.revents=0;
+
+    do {
+	ret=poll(&pfd, 1, (timeout==0) ? -1 : (int)((timeout+999)/1000));
+    } while ((ret<0)&&(errno==EINTR));
+
+    if (ret==0)
+	return VISCA_TIMEOUT;
+    if ((ret<0)||!(pfd.revents & POLLIN))
+	return VISCA_FAILURE;
+
+    return VISCA_SUCCESS;
+}
+
+
+/* Drain whatever the port has to offer into the receive ring buffer with a
+ * single readv(), which only blocks if nothing has been received yet.
+ */
+unsigned int
+_VISCA_fd_receive(VISCAInterface_t *iface)
+{
+    struct iovec iov[2];
+    uint32_t tail, room;
+    ssize_t ret;
+
+    room=VISCA_INPUT_BUFFER_SIZE-(iface->rtail-iface->rhead);
+    if (room==0)
+	return VISCA_FAILURE;
+
+    tail=iface->rtail%VISCA_INPUT_BUFFER_SIZE;
+    iov[0].iov_base=&iface->rbuf[tail];
+    iov[0].iov_len=VISCA_INPUT_BUFFER_SIZE-tail;
+    if (iov[0].iov_len>room)
+	iov[0].iov_len=room;
+    iov[1].iov_base=iface->rbuf;
+    iov[1].iov_len=room-iov[0].iov_len;
+
+    do {
+	ret=readv(iface->port_fd, iov, (iov[1].iov_len>0) ? 2 : 1);
+    } while ((ret<0)&&(errno==EINTR));
+
+    if (ret<=0)
+	return VISCA_FAILURE;
+
+    iface->rtail+=ret;
+
+    return VISCA_SUCCESS;
+}
+
+
+/* Same as above, but first waits until at least one byte is available or
+ * timeout (in us, 0 waits forever) expires.
+ */
+static unsigned int
+_VISCA_fill_input(VISCAInterface_t *iface, uint32_t timeout)
+{
+    uint32_t err;
+
+    err=_VISCA_wait_input(iface, timeout);
+    if (err!=VISCA_SUCCESS)
+	return err;
+
+    return _VISCA_fd_receive(iface);
+}
+
+
+/* Replies travel from a camera, address 1 to 7, to the controller: their
+ * header is 0x90 to 0xF7, with the source address in bits 4-6 and the
+ * destination in bits 0-2. Broadcasts come back around the daisy chain
+ * as 0x88. No other byte of a packet but its terminator has the high bit
+ * set.
+ */
+#define _VISCA_REPLY_HEADER(byte) \
+    (((((byte)&0x88)==0x80)&&(((byte)&0x70)!=0))||((byte)==0x88))
+
+/* longest packet the protocol allows, header and terminator included */
+#define _VISCA_PACKET_MAX                  16
+
+#define _VISCA_RBUF(iface, pos) ((iface)->rbuf[(pos)%VISCA_INPUT_BUFFER_SIZE])
+
+
+/* Drop the received bytes before pos as garbage.
+ */
+static void
+_VISCA_drop_input(VISCAInterface_t *iface, uint32_t pos)
+{
+    if (pos==iface->rhead)
+	return;
+
+    _VISCA_STAT_ADD(iface->stats.resyncs, 1);
+    _VISCA_STAT_ADD(iface->stats.bytes_dropped, pos-iface->rhead);
+    iface->rhead=pos;
+}
+
+
+/* Frame the next packet received into iface->ibuf, without waiting.
+ * Bytes before a reply header are dropped, and so is a packet cut short
+ * by another header or running past _VISCA_PACKET_MAX bytes, so that
+ * framing picks up again at the next header without losing the packet
+ * starting there. Returns VISCA_TIMEOUT if no packet is complete yet.
+ */
+unsigned int
+_VISCA_fd_frame(VISCAInterface_t *iface)
+{
+    uint32_t pos, len, i;
+    unsigned char byte;
+
+    for (;;) {
+	// skip to the next header
+	for (pos=iface->rhead; pos!=iface->rtail; pos++)
+	    if (_VISCA_REPLY_HEADER(_VISCA_RBUF(iface, pos)))
+		break;
+	_VISCA_drop_input(iface, pos);
+	if (iface->rhead==iface->rtail)
+	    return VISCA_TIMEOUT;
+
+	// look for the end of its packet
+	for (pos=iface->rhead+1; pos!=iface->rtail; pos++) {
+	    byte=_VISCA_RBUF(iface, pos);
+	    if ((byte&0x80)||(pos-iface->rhead+1==_VISCA_PACKET_MAX))
+		break;
+	}
+	if (pos==iface->rtail)
+	    return VISCA_TIMEOUT;
+
+	len=pos-iface->rhead+1;
+	if ((byte==VISCA_TERMINATOR)&&(len>=3)) {
+	    // move it to ibuf, leftover bytes stay for the next packet
+	    for (i=0; i<len; i++)
+		iface->ibuf[i]=_VISCA_RBUF(iface, iface->rhead+i);
+	    iface->rhead+=len;
+	    iface->bytes=len;
+	    return VISCA_SUCCESS;
+	}
+
+	// broken packet: resync on the header cutting it short, else past
+	// its last byte
+	_VISCA_drop_input(iface, ((byte&0x80)&&(byte!=VISCA_TERMINATOR)) ? pos : pos+1);
+    }
+}
+
+
+/* Frame the next packet into iface->ibuf, waiting at most timeout us
+ * (0: forever) for it to start.
+ */
+unsigned int
+_VISCA_fd_read_frame(VISCAInterface_t *iface, uint32_t timeout)
+{
+    uint32_t err;
+
+    for (;;) {
+	if (_VISCA_fd_frame(iface)==VISCA_SUCCESS)
+	    return VISCA_SUCCESS;
+
+	// wait timeout for a reply to start, then VISCA_SERIAL_WAIT for
+	// each further chunk of it
+	err=_VISCA_fill_input(iface, (iface->rhead==iface->rtail) ?
+			      timeout : VISCA_SERIAL_WAIT);
+	if (err!=VISCA_SUCCESS) {
+	    // a stalled partial packet is garbage as well
+	    _VISCA_drop_input(iface, iface->rtail);
+	    return err;
+	}
+    }
+}
+
+
+static unsigned int
+_VISCA_read_packet(VISCAInterface_t *iface, uint32_t timeout)
+{
+    return iface->transport->read_frame(iface, timeout);
+}
+
+
 unsigned int
 _VISCA_get_packet(VISCAInterface_t *iface)
 {
-    int pos=0;
-    int bytes_read;
+    return _VISCA_read_packet(iface, iface->timeout);
+}
+
 
-    // wait for message
-    ioctl(iface->port_fd, FIONREAD, &(iface->bytes));
-    while (iface->bytes==0) {
-	usleep(0);
-	ioctl(iface->port_fd, FIONREAD, &(iface->bytes));
+/* Wait for the next reply and route it to its request. Without reader
+ * thread the caller reads it from the port itself. Otherwise the reader
+ * thread does, and the caller sleeps until it signals a routed reply,
+ * or until it stops and the caller reads the port again on its next
+ * call. The caller holds the interface lock.
+ */
+unsigned int
+_VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout)
+{
+    struct timespec ts;
+    uint32_t err;
+    int ret;
+
+    if (!iface->threaded) {
+	err=_VISCA_read_packet(iface, timeout);
+	if (err!=VISCA_SUCCESS)
+	    return err;
+	_VISCA_dispatch_reply(iface);
+	return VISCA_SUCCESS;
     }
 
-    // get octets one by one
-    bytes_read=read(iface->port_fd, iface->ibuf, 1);
-    while (iface->ibuf[pos]!=VISCA_TERMINATOR) {
-	pos++;
-	bytes_read=read(iface->port_fd, &iface->ibuf[pos], 1);
-	usleep(0);
+    if (iface->reader_err!=VISCA_SUCCESS)
+	return iface->reader_err;
+
+    if (timeout==0)
+	ret=pthread_cond_wait(&iface->replied, &iface->lock);
+    else {
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts.tv_sec+=timeout/1000000;
+	ts.tv_nsec+=(long)(timeout%1000000)*1000;
+	if (ts.tv_nsec>=1000000000) {
+	    ts.tv_sec++;
+	    ts.tv_nsec-=1000000000;
+	}
+	do {
+	    ret=pthread_cond_timedwait(&iface->replied, &iface->lock, &ts);
+	} while (ret==EINTR);
     }
-    iface->bytes=pos+1;
+
+    if (ret==ETIMEDOUT)
+	return VISCA_TIMEOUT;
+
+    return iface->reader_err;
+}
+
+
+void
+_VISCA_lock(VISCAInterface_t *iface)
+{
+    pthread_mutex_lock(&iface->lock);
+}
+
+
+void
+_VISCA_unlock(VISCAInterface_t *iface)
+{
+    pthread_mutex_unlock(&iface->lock);
+}
+
+
+/* The reader thread owns the receive buffers: it frames every incoming
+ * packet and routes it to its request under the interface lock, then
+ * wakes up the callers waiting for replies. When stopped, it routes the
+ * packet it has read, and hands the port back to the waiting callers
+ * before waking them up, so that they read it themselves.
+ */
+static void *
+_VISCA_reader(void *arg)
+{
+    VISCAInterface_t *iface=(VISCAInterface_t *)arg;
+    uint32_t err;
+
+    for (;;) {
+	// poll with a short timeout so that a stop request is seen
+	err=_VISCA_read_packet(iface, VISCA_SERIAL_WAIT);
+
+	pthread_mutex_lock(&iface->lock);
+	if (err==VISCA_SUCCESS) {
+	    _VISCA_dispatch_reply(iface);
+	    pthread_cond_broadcast(&iface->replied);
+	}
+	if (iface->stopping) {
+	    iface->threaded=0;
+	    pthread_cond_broadcast(&iface->replied);
+	    pthread_mutex_unlock(&iface->lock);
+	    break;
+	}
+	if ((err!=VISCA_SUCCESS)&&(err!=VISCA_TIMEOUT)) {
+	    iface->reader_err=err;
+	    pthread_cond_broadcast(&iface->replied);
+	    pthread_mutex_unlock(&iface->lock);
+	    break;
+	}
+	pthread_mutex_unlock(&iface->lock);
+    }
+
+    return NULL;
+}
+
+
+unsigned int
+VISCA_start_reader(VISCAInterface_t *iface)
+{
+    pthread_mutex_lock(&iface->lock);
+    // a reader being stopped may still be running
+    if (iface->threaded||iface->stopping) {
+	pthread_mutex_unlock(&iface->lock);
+	return VISCA_FAILURE;
+    }
+    iface->reader_err=VISCA_SUCCESS;
+    if (pthread_create(&iface->reader, NULL, _VISCA_reader, iface)!=0) {
+	pthread_mutex_unlock(&iface->lock);
+	return VISCA_FAILURE;
+    }
+    iface->threaded=1;
+    pthread_mutex_unlock(&iface->lock);
 
     return VISCA_SUCCESS;
 }
 
 
+unsigned int
+VISCA_stop_reader(VISCAInterface_t *iface)
+{
+    pthread_mutex_lock(&iface->lock);
+    if ((!iface->threaded)||iface->stopping) {
+	pthread_mutex_unlock(&iface->lock);
+	return VISCA_FAILURE;
+    }
+    iface->stopping=1;
+    pthread_mutex_unlock(&iface->lock);
+
+    pthread_join(iface->reader, NULL);
+
+    // the reader left the port to the callers already
+    pthread_mutex_lock(&iface->lock);
+    iface->threaded=0;
+    iface->stopping=0;
+    pthread_mutex_unlock(&iface->lock);
+
+    return VISCA_SUCCESS;
+}
+
+
+
+/* Monotonic time in us. It wraps around every 71 minutes, so only
+ * differences of it are meaningful.
+ */
+uint32_t
+_VISCA_get_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec*1000000+(uint32_t)(ts.tv_nsec/1000);
+}
+
+
 
 /***********************************/
 /*       SYSTEM  FUNCTIONS         */
 /***********************************/
 
+/* Set up the state shared by all transports before the transport opens.
+ */
+static void
+_VISCA_init_interface(VISCAInterface_t *iface, const VISCATransport_t *transport)
+{
+  pthread_condattr_t cattr;
+  uint32_t i;
+
+  iface->transport = transport;
+  iface->port_fd = -1;
+  iface->baud = 0;
+  iface->address=0;
+  iface->broadcast=0;
+  iface->timeout=0;
+  iface->retry_max=0;
+  iface->retry_backoff=0;
+  iface->cache=NULL;
+  iface->completion=NULL;
+  iface->io=NULL;
+  iface->rhead=0;
+  iface->rtail=0;
+  iface->requests=NULL;
+  iface->write_tag=0;
+  iface->reply_tag=0;
+  memset(&iface->stats, 0, sizeof(iface->stats));
+  iface->threaded=0;
+  iface->stopping=0;
+  iface->reader_err=VISCA_SUCCESS;
+  iface->seq=0;
+  iface->ip_tags=0;
+  for (i=0;i<VISCA_IP_MESSAGES;i++)
+    iface->ip_msg[i].tag=0;
+  pthread_mutex_init(&iface->lock, NULL);
+  pthread_mutex_init(&iface->ip_lock, NULL);
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+  pthread_cond_init(&iface->replied, &cattr);
+  pthread_condattr_destroy(&cattr);
+}
+
+
+static void
+_VISCA_free_interface(VISCAInterface_t *iface)
+{
+  pthread_cond_destroy(&iface->replied);
+  pthread_mutex_destroy(&iface->ip_lock);
+  pthread_mutex_destroy(&iface->lock);
+  iface->transport = NULL;
+  iface->port_fd = -1;
+}
+
+
 unsigned int
-VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
+VISCA_open_transport(VISCAInterface_t *iface, const VISCATransport_t *transport, const char *name)
+{
+  uint32_t err;
+
+  _VISCA_init_interface(iface, transport);
+  err = transport->open(iface, name);
+  if (err != VISCA_SUCCESS)
+    _VISCA_free_interface(iface);
+
+  return err;
+}
+
+
+unsigned int
+VISCA_close_transport(VISCAInterface_t *iface)
+{
+  uint32_t err;
+
+  if (iface->transport == NULL)
+    return VISCA_FAILURE;
+
+  if (iface->threaded)
+    VISCA_stop_reader(iface);
+  err = iface->transport->close(iface);
+  _VISCA_free_interface(iface);
+
+  return err;
+}
+
+
+/* Map a baud rate in bit/s to its termios speed constant, B0 if the
+ * rate is not supported.
+ */
+static speed_t
+_VISCA_baud_to_speed(uint32_t baud)
+{
+  switch (baud)
+    {
+    case 1200:   return B1200;
+    case 2400:   return B2400;
+    case 4800:   return B4800;
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+#ifdef B57600
+    case 57600:  return B57600;
+#endif
+#ifdef B115200
+    case 115200: return B115200;
+#endif
+    default:     return B0;
+    }
+}
+
+
+/* Open and set up the serial line for the serial transport.
+ */
+static unsigned int
+_VISCA_serial_setup(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags)
 {
   int fd;
+  speed_t speed;
+
+  speed = _VISCA_baud_to_speed(baud);
+  if (speed == B0)
+    {
+#if DEBUG
+      fprintf(stderr,"(%s): unsupported baud rate %u\n",__FILE__,baud);
+#endif
+      return VISCA_FAILURE;
+    }
+
   fd = open(device_name, O_RDWR | O_NDELAY | O_NOCTTY);
 
   if (fd == -1)
@@ -139,7 +634,6 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
 #if DEBUG
       fprintf(stderr,"(%s): cannot open serial device %s\n",__FILE__,device_name);
 #endif
-      iface->port_fd=-1;
       return VISCA_FAILURE;
     }	
   else
@@ -149,15 +643,27 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
       tcgetattr(fd, &iface->options);
 
       /* control flags */
-      cfsetispeed(&iface->options,B9600);    /* 9600 Bds   */
+      cfsetispeed(&iface->options,speed);    /* same speed */
+      cfsetospeed(&iface->options,speed);    /* both ways  */
       iface->options.c_cflag &= ~PARENB;     /* No parity  */
-      iface->options.c_cflag &= ~CSTOPB;     /*            */
       iface->options.c_cflag &= ~CSIZE;      /* 8bit       */
       iface->options.c_cflag |= CS8;         /*            */
-      iface->options.c_cflag &= ~CRTSCTS;    /* No hdw ctl */
+      iface->options.c_cflag |= (CLOCAL | CREAD);
+
+      if (flags & VISCA_SERIAL_STOPB2)
+	iface->options.c_cflag |= CSTOPB;    /* 2 stop bits */
+      else
+	iface->options.c_cflag &= ~CSTOPB;   /* 1 stop bit  */
+
+      if (flags & VISCA_SERIAL_CRTSCTS)
+	iface->options.c_cflag |= CRTSCTS;   /* hdw ctl    */
+      else
+	iface->options.c_cflag &= ~CRTSCTS;  /* No hdw ctl */
 
       /* local flags */
       iface->options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG); /* raw input */
+      iface->options.c_cc[VMIN] = 1;         /* return what is there */
+      iface->options.c_cc[VTIME] = 0;
 
       /* input flags */
       /*
@@ -170,25 +676,62 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
       /* output flags */
       iface->options.c_oflag &= ~OPOST; /* raw output */
 
-      tcsetattr(fd, TCSANOW, &iface->options);
-
+      if (tcsetattr(fd, TCSANOW, &iface->options) != 0)
+	{
+#if DEBUG
+	  fprintf(stderr,"(%s): cannot set line settings on %s\n",__FILE__,device_name);
+#endif
+	  close(fd);
+	  return VISCA_FAILURE;
+	}
     }
   iface->port_fd = fd;
-  iface->address=0;
+  iface->baud = baud;
 
   return VISCA_SUCCESS;
 }
 
 
+static unsigned int
+_VISCA_serial_open(VISCAInterface_t *iface, const char *device_name)
+{
+  return _VISCA_serial_setup(iface, device_name, 9600, VISCA_SERIAL_DEFAULT);
+}
+
+
+const VISCATransport_t VISCA_serial_transport = {
+  "serial",
+  _VISCA_serial_open,
+  _VISCA_fd_write,
+  _VISCA_fd_read_frame,
+  _VISCA_wait_input,
+  _VISCA_fd_close
+};
+
+
+unsigned int
+VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
+{
+  return VISCA_open_transport(iface, &VISCA_serial_transport, device_name);
+}
+
+
+unsigned int
+VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags)
+{
+  uint32_t err;
+
+  _VISCA_init_interface(iface, &VISCA_serial_transport);
+  err = _VISCA_serial_setup(iface, device_name, baud, flags);
+  if (err != VISCA_SUCCESS)
+    _VISCA_free_interface(iface);
+
+  return err;
+}
+
+
 unsigned int
 VISCA_close_serial(VISCAInterface_t *iface)
 {
-  if (iface->port_fd!=-1)
-    {
-      close(iface->port_fd);
-      iface->port_fd = -1;
-      return VISCA_SUCCESS;
-    }
-  else
-    return VISCA_FAILURE;
+  return VISCA_close_transport(iface);
 }
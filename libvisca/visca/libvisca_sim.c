@@ -0,0 +1,1330 @@
+/*
+ * VISCA(tm) Camera Control Library
+ * Copyright (C) 2002 Damien Douxchamps
+ *
+ * Written by Damien Douxchamps <ddouxchamps@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/* Simulated VISCA cameras for tests and benchmarks on the POSIX platform.
+ *
+ * The simulator takes the packets sent to the chain and queues the replies
+ * the cameras would send, each with the time it is due. The replies only
+ * depend on the packets and on the times they arrive, so runs are
+ * repeatable. Motors move linearly at their slew rate, their position is
+ * worked out when it is inquired.
+ *
+ * In the DIRECT mode the packets are handed over in memory. In the
+ * SOCKETPAIR and PTY modes a server thread answers on a file descriptor,
+ * so that the I/O code of the library is exercised as well. In the UDP
+ * mode it stands in for VISCA over IP cameras: each packet comes in a
+ * datagram behind the 8 byte header, and the replies go out with the
+ * sequence number of the message they answer.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <libvisca.h>
+
+
+/* implemented in libvisca_posix.c
+ */
+unsigned int _VISCA_fd_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length);
+unsigned int _VISCA_fd_read_frame(VISCAInterface_t *iface, uint32_t timeout);
+unsigned int _VISCA_fd_close(VISCAInterface_t *iface);
+unsigned int _VISCA_wait_input(VISCAInterface_t *iface, uint32_t timeout);
+
+/* implemented in libvisca_ip.c
+ */
+unsigned int _VISCA_ip_open(VISCAInterface_t *iface, const char *name);
+unsigned int _VISCA_ip_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length);
+unsigned int _VISCA_ip_read_frame(VISCAInterface_t *iface, uint32_t timeout);
+
+
+/* motor ranges */
+#define VISCA_SIM_ZOOM_MIN             0x0000
+#define VISCA_SIM_ZOOM_MAX             0x4000
+#define VISCA_SIM_FOCUS_MIN            0x1000
+#define VISCA_SIM_FOCUS_MAX            0xC000
+#define VISCA_SIM_PAN_LIMIT               880
+#define VISCA_SIM_TILT_LIMIT              300
+#define VISCA_SIM_PAN_SPEED_MAX          0x18
+#define VISCA_SIM_TILT_SPEED_MAX         0x14
+
+/* VISCA over IP messages are taken up to this far from the last sequence
+ * number */
+#define VISCA_SIM_SEQ_WINDOW               32
+
+
+/***********************************/
+/*             MOTORS              */
+/***********************************/
+
+static int32_t
+_VISCA_sim_position(VISCASimAxis_t *axis, uint32_t now)
+{
+  int64_t moved, dist;
+
+  moved=(int64_t)axis->rate*(uint32_t)(now-axis->start)/1000000;
+  dist=(int64_t)axis->to-axis->from;
+
+  if (dist>=0)
+    return (moved>=dist) ? axis->to : axis->from+(int32_t)moved;
+  else
+    return (moved>=-dist) ? axis->to : axis->from-(int32_t)moved;
+}
+
+
+/* Start moving to 'to' at rate positions per second, rate 0 stops. Returns
+ * the time the move takes, in us.
+ */
+static uint32_t
+_VISCA_sim_move(VISCASimAxis_t *axis, uint32_t now, int32_t to, uint32_t rate)
+{
+  int64_t dist;
+
+  axis->from=_VISCA_sim_position(axis, now);
+  axis->start=now;
+  axis->rate=rate;
+  axis->to=(rate>0) ? to : axis->from;
+
+  dist=(int64_t)axis->to-axis->from;
+  if (dist<0)
+    dist=-dist;
+
+  return (rate>0) ? (uint32_t)(dist*1000000/rate) : 0;
+}
+
+
+/* Zoom and focus drive: 00 stop, 02/03 standard speed, 2p/3p variable
+ * speed p towards max/min.
+ */
+static void
+_VISCA_sim_drive(VISCASimAxis_t *axis, uint32_t now, unsigned char code, int32_t min, int32_t max, uint32_t rate)
+{
+  if ((code==0x02)||(code==0x03))
+    rate=rate/2;
+  else
+    rate=rate*((code&0x07)+1)/8;
+
+  switch (code&0xF0)
+    {
+    case 0x00:
+      if (code==0x02)
+	_VISCA_sim_move(axis, now, max, rate);
+      else if (code==0x03)
+	_VISCA_sim_move(axis, now, min, rate);
+      else
+	_VISCA_sim_move(axis, now, 0, 0);
+      break;
+    case 0x20:
+      _VISCA_sim_move(axis, now, max, rate);
+      break;
+    case 0x30:
+      _VISCA_sim_move(axis, now, min, rate);
+      break;
+    }
+}
+
+
+static uint32_t
+_VISCA_sim_nibbles(const unsigned char *p, uint32_t count)
+{
+  uint32_t value=0;
+
+  while (count-->0)
+    value=(value<<4)|(*p++&0x0F);
+
+  return value;
+}
+
+
+static int32_t
+_VISCA_sim_clamp(int32_t value, int32_t min, int32_t max)
+{
+  return (value<min) ? min : (value>max) ? max : value;
+}
+
+
+/***********************************/
+/*             REPLIES             */
+/***********************************/
+
+/* Queue a reply, after those due at the same time.
+ */
+static void
+_VISCA_sim_queue(VISCASim_t *sim, uint32_t due, uint32_t address, uint32_t socket, const unsigned char *bytes, uint32_t length)
+{
+  VISCASimReply_t *reply;
+  uint32_t i;
+
+  if ((sim->replies==VISCA_SIM_REPLIES)||(length>sizeof(reply->bytes)))
+    return;
+
+  for (i=sim->replies; i>0; i--)
+    if ((int32_t)(sim->reply[i-1].due-due)<=0)
+      break;
+  memmove(&sim->reply[i+1], &sim->reply[i], (sim->replies-i)*sizeof(VISCASimReply_t));
+  sim->replies++;
+
+  reply=&sim->reply[i];
+  reply->due=due;
+  reply->address=address;
+  reply->socket=socket;
+  reply->seq=sim->seq;
+  memcpy(reply->bytes, bytes, length);
+  reply->length=length;
+}
+
+
+/* Queue the reply of camera 'address' made of payload and terminator.
+ */
+static void
+_VISCA_sim_answer(VISCASim_t *sim, uint32_t due, uint32_t address, uint32_t socket, const unsigned char *payload, uint32_t length)
+{
+  unsigned char bytes[16];
+
+  bytes[0]=(address+8)<<4;
+  memcpy(&bytes[1], payload, length);
+  bytes[length+1]=VISCA_TERMINATOR;
+
+  _VISCA_sim_queue(sim, due, address, socket, bytes, length+2);
+}
+
+
+/* Drop the pending Completion of a socket (any socket for 0) and free it.
+ */
+static void
+_VISCA_sim_cancel(VISCASim_t *sim, uint32_t address, uint32_t socket)
+{
+  VISCASimCamera_t *cam=&sim->camera[address-1];
+  uint32_t i, j;
+
+  for (i=0, j=0; i<sim->replies; i++)
+    {
+      if ((sim->reply[i].address==address)&&(sim->reply[i].socket!=0)&&
+	  ((socket==0)||(sim->reply[i].socket==socket)))
+	continue;
+      sim->reply[j++]=sim->reply[i];
+    }
+  sim->replies=j;
+
+  for (i=0; i<2; i++)
+    if ((socket==0)||(socket==i+1))
+      cam->socket_busy[i]=0;
+}
+
+
+/* Whether a reply is pending, and in how many us it is due.
+ */
+static int
+_VISCA_sim_due(VISCASim_t *sim, uint32_t now, uint32_t *wait)
+{
+  if (sim->replies==0)
+    return 0;
+
+  *wait=((int32_t)(sim->reply[0].due-now)>0) ? sim->reply[0].due-now : 0;
+  return 1;
+}
+
+
+static int
+_VISCA_sim_pop(VISCASim_t *sim, uint32_t now, unsigned char *bytes, uint32_t *length, uint32_t *seq)
+{
+  uint32_t wait;
+
+  if (!_VISCA_sim_due(sim, now, &wait)||(wait>0))
+    return 0;
+
+  memcpy(bytes, sim->reply[0].bytes, sim->reply[0].length);
+  *length=sim->reply[0].length;
+  if (seq!=NULL)
+    *seq=sim->reply[0].seq;
+  sim->replies--;
+  memmove(&sim->reply[0], &sim->reply[1], sim->replies*sizeof(VISCASimReply_t));
+
+  return 1;
+}
+
+
+/***********************************/
+/*            CAMERAS              */
+/***********************************/
+
+static unsigned char *
+_VISCA_sim_register(VISCASimCamera_t *cam, unsigned char category, unsigned char id, int create)
+{
+  uint32_t i;
+
+  for (i=0; i<cam->registers; i++)
+    if ((cam->reg[i][0]==category)&&(cam->reg[i][1]==id))
+      return cam->reg[i];
+
+  if (!create||(cam->registers==VISCA_SIM_REGISTERS))
+    return NULL;
+
+  cam->reg[i][0]=category;
+  cam->reg[i][1]=id;
+  cam->reg[i][2]=0;
+  cam->registers++;
+
+  return cam->reg[i];
+}
+
+
+/* Carry out a command, msg being 01 category id parameters. Returns the
+ * time its motors take, in us.
+ */
+static uint32_t
+_VISCA_sim_execute(VISCASim_t *sim, VISCASimCamera_t *cam, const unsigned char *msg, uint32_t length, uint32_t now)
+{
+  const unsigned char *p=&msg[3];
+  uint32_t n=length-3, t1, t2, pan_rate, tilt_rate;
+  int32_t pan, tilt;
+  unsigned char *reg;
+
+  switch (msg[1])
+    {
+    case VISCA_CATEGORY_CAMERA1:
+      switch (msg[2])
+	{
+	case VISCA_ZOOM:
+	  if (n>=1)
+	    _VISCA_sim_drive(&cam->zoom, now, p[0], VISCA_SIM_ZOOM_MIN, VISCA_SIM_ZOOM_MAX, sim->zoom_rate);
+	  return 0;
+
+	case VISCA_FOCUS:
+	  if (n>=1)
+	    _VISCA_sim_drive(&cam->focus, now, p[0], VISCA_SIM_FOCUS_MIN, VISCA_SIM_FOCUS_MAX, sim->focus_rate);
+	  return 0;
+
+	case VISCA_ZOOM_VALUE:
+	  t1=t2=0;
+	  if (n>=4)
+	    t1=_VISCA_sim_move(&cam->zoom, now, _VISCA_sim_clamp(_VISCA_sim_nibbles(p, 4), VISCA_SIM_ZOOM_MIN, VISCA_SIM_ZOOM_MAX), sim->zoom_rate);
+	  if (n>=8)   // zoom and focus
+	    t2=_VISCA_sim_move(&cam->focus, now, _VISCA_sim_clamp(_VISCA_sim_nibbles(&p[4], 4), VISCA_SIM_FOCUS_MIN, VISCA_SIM_FOCUS_MAX), sim->focus_rate);
+	  return (t1>t2) ? t1 : t2;
+
+	case VISCA_FOCUS_VALUE:
+	  if (n>=4)
+	    return _VISCA_sim_move(&cam->focus, now, _VISCA_sim_clamp(_VISCA_sim_nibbles(p, 4), VISCA_SIM_FOCUS_MIN, VISCA_SIM_FOCUS_MAX), sim->focus_rate);
+	  return 0;
+
+	case VISCA_POWER:
+	  if (n>=1)
+	    cam->power=(p[0]==VISCA_ON);
+	  return 0;
+	}
+      break;
+
+    case VISCA_CATEGORY_PAN_TILTER:
+      pan_rate=sim->pan_rate*((n>=1) ? p[0] : 0);
+      tilt_rate=sim->tilt_rate*((n>=2) ? p[1] : 0);
+      switch (msg[2])
+	{
+	case VISCA_PT_DRIVE:
+	  if (n<4)
+	    return 0;
+	  if (p[2]==VISCA_PT_DRIVE_HORIZ_LEFT)
+	    _VISCA_sim_move(&cam->pan, now, -VISCA_SIM_PAN_LIMIT, pan_rate);
+	  else if (p[2]==VISCA_PT_DRIVE_HORIZ_RIGHT)
+	    _VISCA_sim_move(&cam->pan, now, VISCA_SIM_PAN_LIMIT, pan_rate);
+	  else
+	    _VISCA_sim_move(&cam->pan, now, 0, 0);
+	  if (p[3]==VISCA_PT_DRIVE_VERT_UP)
+	    _VISCA_sim_move(&cam->tilt, now, VISCA_SIM_TILT_LIMIT, tilt_rate);
+	  else if (p[3]==VISCA_PT_DRIVE_VERT_DOWN)
+	    _VISCA_sim_move(&cam->tilt, now, -VISCA_SIM_TILT_LIMIT, tilt_rate);
+	  else
+	    _VISCA_sim_move(&cam->tilt, now, 0, 0);
+	  return 0;
+
+	case VISCA_PT_ABSOLUTE_POSITION:
+	case VISCA_PT_RELATIVE_POSITION:
+	  if (n<11)
+	    return 0;
+	  // 5 nibbles of pan, 4 of tilt, both two's complement
+	  pan=_VISCA_sim_nibbles(&p[2], 5);
+	  if (pan&0x80000)
+	    pan-=0x100000;
+	  tilt=(int16_t)_VISCA_sim_nibbles(&p[7], 4);
+	  if (msg[2]==VISCA_PT_RELATIVE_POSITION)
+	    {
+	      pan+=_VISCA_sim_position(&cam->pan, now);
+	      tilt+=_VISCA_sim_position(&cam->tilt, now);
+	    }
+	  t1=_VISCA_sim_move(&cam->pan, now, _VISCA_sim_clamp(pan, -VISCA_SIM_PAN_LIMIT, VISCA_SIM_PAN_LIMIT), pan_rate);
+	  t2=_VISCA_sim_move(&cam->tilt, now, _VISCA_sim_clamp(tilt, -VISCA_SIM_TILT_LIMIT, VISCA_SIM_TILT_LIMIT), tilt_rate);
+	  return (t1>t2) ? t1 : t2;
+
+	case VISCA_PT_HOME:
+	case VISCA_PT_RESET:
+	  t1=_VISCA_sim_move(&cam->pan, now, 0, sim->pan_rate*VISCA_SIM_PAN_SPEED_MAX);
+	  t2=_VISCA_sim_move(&cam->tilt, now, 0, sim->tilt_rate*VISCA_SIM_TILT_SPEED_MAX);
+	  return (t1>t2) ? t1 : t2;
+	}
+      break;
+    }
+
+  // anything else is a setting, remembered for its inquiry
+  reg=_VISCA_sim_register(cam, msg[1], msg[2], 1);
+  if (reg!=NULL)
+    {
+      if (n>13)
+	n=13;
+      reg[2]=n;
+      memcpy(&reg[3], p, n);
+    }
+
+  return 0;
+}
+
+
+static void
+_VISCA_sim_command(VISCASim_t *sim, uint32_t address, const unsigned char *msg, uint32_t length, uint32_t now)
+{
+  VISCASimCamera_t *cam=&sim->camera[address-1];
+  unsigned char payload[2];
+  uint32_t s, ack, done, travel;
+
+  if (length<3)
+    {
+      payload[0]=VISCA_RESPONSE_ERROR;
+      payload[1]=VISCA_ERROR_SYNTAX;
+      _VISCA_sim_answer(sim, now+sim->inquiry_delay, address, 0, payload, 2);
+      return;
+    }
+
+  // IF_Clear empties the command buffer
+  if ((msg[1]==VISCA_CATEGORY_INTERFACE)&&(msg[2]==0x01))
+    {
+      _VISCA_sim_cancel(sim, address, 0);
+      payload[0]=VISCA_RESPONSE_COMPLETED;
+      _VISCA_sim_answer(sim, now+sim->ack_delay, address, 0, payload, 1);
+      return;
+    }
+
+  for (s=0; s<2; s++)
+    if (!cam->socket_busy[s]||((int32_t)(now-cam->socket_done[s])>=0))
+      break;
+
+  if (s==2)
+    {
+      payload[0]=VISCA_RESPONSE_ERROR;
+      payload[1]=VISCA_ERROR_CMD_BUFFER_FULL;
+      _VISCA_sim_answer(sim, now+sim->ack_delay, address, 0, payload, 2);
+      return;
+    }
+
+  ack=now+sim->ack_delay;
+  payload[0]=VISCA_RESPONSE_ACK|(s+1);
+  _VISCA_sim_answer(sim, ack, address, 0, payload, 1);
+
+  if (!cam->power&&!((msg[1]==VISCA_CATEGORY_CAMERA1)&&(msg[2]==VISCA_POWER)))
+    {
+      done=ack+sim->completion_delay;
+      payload[0]=VISCA_RESPONSE_ERROR|(s+1);
+      payload[1]=VISCA_ERROR_CMD_NOT_EXECUTABLE;
+      _VISCA_sim_answer(sim, done, address, s+1, payload, 2);
+    }
+  else
+    {
+      travel=_VISCA_sim_execute(sim, cam, msg, length, now);
+      done=ack+((travel>sim->completion_delay) ? travel : sim->completion_delay);
+      payload[0]=VISCA_RESPONSE_COMPLETED|(s+1);
+      _VISCA_sim_answer(sim, done, address, s+1, payload, 1);
+    }
+
+  cam->socket_busy[s]=1;
+  cam->socket_done[s]=done;
+}
+
+
+/* Value a setting was last given, def if it never was.
+ */
+static uint32_t
+_VISCA_sim_setting(VISCASimCamera_t *cam, unsigned char category, unsigned char id, uint32_t def)
+{
+  unsigned char *reg=_VISCA_sim_register(cam, category, id, 0);
+
+  if ((reg==NULL)||(reg[2]==0))
+    return def;
+
+  return _VISCA_sim_nibbles(&reg[3], reg[2]);
+}
+
+
+/* Fill in the 13 bytes of a block inquiry reply, laid out as decoded by
+ * VISCA_get_block(). Returns 0 for an unknown block.
+ */
+static uint32_t
+_VISCA_sim_block(VISCASimCamera_t *cam, unsigned char block, unsigned char *r, uint32_t now)
+{
+  uint32_t value, i;
+
+  memset(r, 0, 13);
+  switch (block)
+    {
+    case VISCA_BLOCK_LENS:
+      value=_VISCA_sim_position(&cam->zoom, now);
+      for (i=0; i<4; i++)
+	r[i]=(value>>(12-4*i))&0x0F;
+      value=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_NEAR_LIMIT, 0x1000);
+      r[4]=(value>>12)&0x0F;
+      r[5]=(value>>8)&0x0F;
+      value=_VISCA_sim_position(&cam->focus, now);
+      for (i=0; i<4; i++)
+	r[6+i]=(value>>(12-4*i))&0x0F;
+      r[11]=0x02;
+      if (_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_FOCUS_AUTO, VISCA_ON)==VISCA_ON)
+	r[11]|=0x01;
+      if (_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_DZOOM, VISCA_OFF)==VISCA_ON)
+	r[11]|=0x04;
+      if (_VISCA_sim_position(&cam->zoom, now)!=cam->zoom.to)
+	r[12]|=0x01;
+      if (_VISCA_sim_position(&cam->focus, now)!=cam->focus.to)
+	r[12]|=0x02;
+      return 1;
+
+    case VISCA_BLOCK_CAMERA:
+      value=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_RGAIN_VALUE, 0);
+      r[0]=(value>>4)&0x0F;
+      r[1]=value&0x0F;
+      value=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_BGAIN_VALUE, 0);
+      r[2]=(value>>4)&0x0F;
+      r[3]=value&0x0F;
+      r[4]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_WB, 0);
+      r[5]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_APERTURE_VALUE, 0);
+      r[6]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_AUTO_EXP, 0);
+      if (_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_SLOW_SHUTTER, VISCA_OFF)==VISCA_ON)
+	r[7]|=0x01;
+      if (_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP_POWER, VISCA_OFF)==VISCA_ON)
+	r[7]|=0x02;
+      if (_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_BACKLIGHT_COMP, VISCA_OFF)==VISCA_ON)
+	r[7]|=0x04;
+      r[8]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_SHUTTER_VALUE, 0);
+      r[9]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_IRIS_VALUE, 0);
+      r[10]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_GAIN_VALUE, 0);
+      r[11]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_BRIGHT_VALUE, 0);
+      r[12]=_VISCA_sim_setting(cam, VISCA_CATEGORY_CAMERA1, VISCA_EXP_COMP_VALUE, 0);
+      return 1;
+
+    case VISCA_BLOCK_OTHER:
+    case VISCA_BLOCK_ENLARGEMENT:
+      return 1;
+    }
+
+  return 0;
+}
+
+
+static void
+_VISCA_sim_inquiry(VISCASim_t *sim, uint32_t address, const unsigned char *msg, uint32_t length, uint32_t now)
+{
+  VISCASimCamera_t *cam=&sim->camera[address-1];
+  unsigned char payload[14], *reg;
+  uint32_t n=1, value, i;
+  int32_t pan, tilt;
+
+  payload[0]=VISCA_RESPONSE_COMPLETED;
+
+  if (length<3)
+    {
+      payload[0]=VISCA_RESPONSE_ERROR;
+      payload[n++]=VISCA_ERROR_SYNTAX;
+    }
+  else if ((msg[1]==VISCA_CATEGORY_INTERFACE)&&(msg[2]==VISCA_DEVICE_INFO))
+    {
+      // camera info: vendor, model, ROM version, sockets
+      payload[n++]=0x00;
+      payload[n++]=0x20;
+      payload[n++]=(sim->model>>8)&0xFF;
+      payload[n++]=sim->model&0xFF;
+      payload[n++]=0x00;
+      payload[n++]=0x01;
+      payload[n++]=0x02;
+    }
+  else if ((msg[1]==VISCA_BLOCK_INQUIRY)&&(msg[2]==VISCA_BLOCK_INQUIRY))
+    {
+      if ((length>=4)&&_VISCA_sim_block(cam, msg[3], &payload[n], now))
+	n+=13;
+      else
+	{
+	  payload[0]=VISCA_RESPONSE_ERROR;
+	  payload[n++]=VISCA_ERROR_SYNTAX;
+	}
+    }
+  else if ((msg[1]==VISCA_CATEGORY_CAMERA1)&&(msg[2]==VISCA_POWER))
+    payload[n++]=cam->power ? VISCA_ON : VISCA_OFF;
+  else if ((msg[1]==VISCA_CATEGORY_CAMERA1)&&
+	   ((msg[2]==VISCA_ZOOM_VALUE)||(msg[2]==VISCA_FOCUS_VALUE)))
+    {
+      value=_VISCA_sim_position((msg[2]==VISCA_ZOOM_VALUE) ? &cam->zoom : &cam->focus, now);
+      for (i=0; i<4; i++)
+	payload[n++]=(value>>(12-4*i))&0x0F;
+    }
+  else if ((msg[1]==VISCA_CATEGORY_PAN_TILTER)&&(msg[2]==VISCA_PT_POSITION_INQ))
+    {
+      pan=_VISCA_sim_position(&cam->pan, now);
+      tilt=_VISCA_sim_position(&cam->tilt, now);
+      payload[n++]=((uint32_t)pan>>16)&0x0F;
+      for (i=0; i<4; i++)
+	payload[n++]=((uint32_t)pan>>(12-4*i))&0x0F;
+      for (i=0; i<4; i++)
+	payload[n++]=((uint32_t)tilt>>(12-4*i))&0x0F;
+    }
+  else
+    {
+      reg=_VISCA_sim_register(cam, msg[1], msg[2], 0);
+      if (reg!=NULL)
+	{
+	  memcpy(&payload[n], &reg[3], reg[2]);
+	  n+=reg[2];
+	}
+      else
+	payload[n++]=0x00;
+    }
+
+  _VISCA_sim_answer(sim, now+sim->inquiry_delay, address, 0, payload, n);
+}
+
+
+/* Take a whole packet, header to terminator, arrived at time now.
+ */
+static void
+_VISCA_sim_packet(VISCASim_t *sim, const unsigned char *packet, uint32_t length, uint32_t now)
+{
+  unsigned char payload[4];
+  uint32_t address, s;
+
+  sim->packets++;
+  if ((length<3)||(packet[length-1]!=VISCA_TERMINATOR))
+    return;
+
+  if (packet[0]&0x08)
+    {
+      // broadcasts go through the whole chain
+      if ((packet[1]==0x30)&&(packet[2]==0x01))
+	{
+	  payload[0]=0x88;
+	  payload[1]=0x30;
+	  payload[2]=sim->cameras+1;
+	  payload[3]=VISCA_TERMINATOR;
+	  _VISCA_sim_queue(sim, now+sim->ack_delay, 0, 0, payload, 4);
+	}
+      else if ((length==5)&&(packet[1]==0x01)&&(packet[2]==0x00)&&(packet[3]==0x01))
+	{
+	  for (address=1; address<=sim->cameras; address++)
+	    _VISCA_sim_cancel(sim, address, 0);
+	  _VISCA_sim_queue(sim, now+sim->ack_delay, 0, 0, packet, length);
+	}
+      return;
+    }
+
+  address=packet[0]&0x07;
+  if ((address<1)||(address>sim->cameras))
+    return;
+
+  packet++;
+  length-=2;
+
+  if (packet[0]==VISCA_COMMAND)
+    _VISCA_sim_command(sim, address, packet, length, now);
+  else if (packet[0]==VISCA_INQUIRY)
+    _VISCA_sim_inquiry(sim, address, packet, length, now);
+  else if ((packet[0]&0xF0)==0x20)
+    {
+      // cancel
+      s=packet[0]&0x0F;
+      payload[0]=VISCA_RESPONSE_ERROR|s;
+      if ((s>=1)&&(s<=2)&&sim->camera[address-1].socket_busy[s-1]&&
+	  ((int32_t)(now-sim->camera[address-1].socket_done[s-1])<0))
+	{
+	  _VISCA_sim_cancel(sim, address, s);
+	  payload[1]=VISCA_ERROR_CMD_CANCELLED;
+	}
+      else
+	payload[1]=VISCA_ERROR_NO_SOCKET;
+      _VISCA_sim_answer(sim, now+sim->ack_delay, address, 0, payload, 2);
+    }
+  else
+    {
+      payload[0]=VISCA_RESPONSE_ERROR;
+      payload[1]=VISCA_ERROR_SYNTAX;
+      _VISCA_sim_answer(sim, now+sim->ack_delay, address, 0, payload, 2);
+    }
+}
+
+
+/***********************************/
+/*         DIRECT TRANSPORT        */
+/***********************************/
+
+static unsigned int
+_VISCA_sim_open(VISCAInterface_t *iface, const char *name)
+{
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_sim_write(VISCAInterface_t *iface, const unsigned char *bytes, uint32_t length)
+{
+  VISCASim_t *sim=(VISCASim_t *)iface->transport_data;
+
+  pthread_mutex_lock(&sim->lock);
+  _VISCA_sim_packet(sim, bytes, length, _VISCA_get_time());
+  pthread_cond_broadcast(&sim->changed);
+  pthread_mutex_unlock(&sim->lock);
+
+  return VISCA_SUCCESS;
+}
+
+
+/* Wait up to timeout us for a reply to be due, and take it if asked to.
+ */
+static unsigned int
+_VISCA_sim_get(VISCAInterface_t *iface, uint32_t timeout, int take)
+{
+  VISCASim_t *sim=(VISCASim_t *)iface->transport_data;
+  struct timespec ts;
+  uint32_t start, now, wait, left;
+  int pending;
+
+  start=_VISCA_get_time();
+  pthread_mutex_lock(&sim->lock);
+
+  for (;;)
+    {
+      now=_VISCA_get_time();
+      pending=_VISCA_sim_due(sim, now, &wait);
+      if (pending&&(wait==0))
+	{
+	  if (take)
+	    _VISCA_sim_pop(sim, now, iface->ibuf, &iface->bytes, NULL);
+	  pthread_mutex_unlock(&sim->lock);
+	  return VISCA_SUCCESS;
+	}
+
+      if (timeout>0)
+	{
+	  if (now-start>=timeout)
+	    {
+	      pthread_mutex_unlock(&sim->lock);
+	      return VISCA_TIMEOUT;
+	    }
+	  left=timeout-(now-start);
+	  if (!pending||(wait>left))
+	    wait=left;
+	  pending=1;
+	}
+
+      if (!pending)
+	pthread_cond_wait(&sim->changed, &sim->lock);
+      else
+	{
+	  clock_gettime(CLOCK_MONOTONIC, &ts);
+	  ts.tv_sec+=wait/1000000;
+	  ts.tv_nsec+=(long)(wait%1000000)*1000;
+	  if (ts.tv_nsec>=1000000000)
+	    {
+	      ts.tv_sec++;
+	      ts.tv_nsec-=1000000000;
+	    }
+	  pthread_cond_timedwait(&sim->changed, &sim->lock, &ts);
+	}
+    }
+}
+
+
+static unsigned int
+_VISCA_sim_read_frame(VISCAInterface_t *iface, uint32_t timeout)
+{
+  return _VISCA_sim_get(iface, timeout, 1);
+}
+
+
+static unsigned int
+_VISCA_sim_wait(VISCAInterface_t *iface, uint32_t timeout)
+{
+  return _VISCA_sim_get(iface, timeout, 0);
+}
+
+
+static unsigned int
+_VISCA_sim_close(VISCAInterface_t *iface)
+{
+  return VISCA_SUCCESS;
+}
+
+
+static const VISCATransport_t _VISCA_sim_direct_transport = {
+  "sim",
+  _VISCA_sim_open,
+  _VISCA_sim_write,
+  _VISCA_sim_read_frame,
+  _VISCA_sim_wait,
+  _VISCA_sim_close
+};
+
+
+/***********************************/
+/*        STREAM TRANSPORTS        */
+/***********************************/
+
+/* Server thread: frames the packets coming in on sim->fd and writes the
+ * replies out as they fall due.
+ */
+static void *
+_VISCA_sim_serve(void *arg)
+{
+  VISCASim_t *sim=(VISCASim_t *)arg;
+  struct pollfd pfd[2];
+  unsigned char buf[64], out[16];
+  uint32_t now, wait, length;
+  ssize_t ret, i;
+  int pending;
+
+  pfd[0].fd=sim->fd;
+  pfd[0].events=POLLIN;
+  pfd[1].fd=sim->wake[0];
+  pfd[1].events=POLLIN;
+
+  for (;;)
+    {
+      pthread_mutex_lock(&sim->lock);
+      now=_VISCA_get_time();
+      while (_VISCA_sim_pop(sim, now, out, &length, NULL))
+	{
+	  pthread_mutex_unlock(&sim->lock);
+	  if (write(sim->fd, out, length)!=(ssize_t)length)
+	    return NULL;
+	  pthread_mutex_lock(&sim->lock);
+	  now=_VISCA_get_time();
+	}
+      pending=_VISCA_sim_due(sim, now, &wait);
+      pthread_mutex_unlock(&sim->lock);
+
+      ret=poll(pfd, 2, pending ? (int)((wait+999)/1000) : -1);
+      if (ret<0)
+	{
+	  if (errno==EINTR)
+	    continue;
+	  break;
+	}
+      if (pfd[1].revents)
+	break;
+      if (!(pfd[0].revents&POLLIN))
+	{
+	  if (pfd[0].revents)
+	    break;
+	  continue;
+	}
+
+      ret=read(sim->fd, buf, sizeof(buf));
+      if (ret<=0)
+	{
+	  if ((ret<0)&&((errno==EINTR)||(errno==EAGAIN)))
+	    continue;
+	  break;
+	}
+
+      now=_VISCA_get_time();
+      pthread_mutex_lock(&sim->lock);
+      for (i=0; i<ret; i++)
+	{
+	  // overlong packets are dropped up to their terminator
+	  if (sim->in_length<sizeof(sim->in))
+	    sim->in[sim->in_length]=buf[i];
+	  sim->in_length++;
+	  if (buf[i]==VISCA_TERMINATOR)
+	    {
+	      if (sim->in_length<=sizeof(sim->in))
+		_VISCA_sim_packet(sim, sim->in, sim->in_length, now);
+	      sim->in_length=0;
+	    }
+	}
+      pthread_mutex_unlock(&sim->lock);
+    }
+
+  return NULL;
+}
+
+
+/***********************************/
+/*          VISCA OVER IP          */
+/***********************************/
+
+static void
+_VISCA_sim_ip_header(unsigned char *header, uint32_t type, uint32_t length, uint32_t seq)
+{
+  header[0]=(type>>8)&0xFF;
+  header[1]=type&0xFF;
+  header[2]=(length>>8)&0xFF;
+  header[3]=length&0xFF;
+  header[4]=(seq>>24)&0xFF;
+  header[5]=(seq>>16)&0xFF;
+  header[6]=(seq>>8)&0xFF;
+  header[7]=seq&0xFF;
+}
+
+
+/* Take a datagram from the client, leaving a control reply to send back
+ * in out (length 0: none). Messages sent again, or overtaken by later
+ * ones, are still taken within VISCA_SIM_SEQ_WINDOW of the last sequence
+ * number. The caller holds sim->lock.
+ */
+static void
+_VISCA_sim_datagram(VISCASim_t *sim, const unsigned char *msg, uint32_t length, uint32_t now,
+		    unsigned char *out, uint32_t *out_length)
+{
+  uint32_t type, seq;
+
+  *out_length=0;
+  type=(msg[0]<<8)|msg[1];
+  seq=((uint32_t)msg[4]<<24)|(msg[5]<<16)|(msg[6]<<8)|msg[7];
+  msg+=VISCA_IP_HEADER_SIZE;
+  length-=VISCA_IP_HEADER_SIZE;
+
+  switch (type)
+    {
+    case VISCA_IP_CONTROL:
+      if ((length==1)&&(msg[0]==VISCA_IP_RESET))
+	{
+	  sim->last_seq=0;
+	  _VISCA_sim_ip_header(out, VISCA_IP_CONTROL_REPLY, 1, seq);
+	  out[VISCA_IP_HEADER_SIZE]=VISCA_IP_RESET;
+	  *out_length=VISCA_IP_HEADER_SIZE+1;
+	}
+      break;
+
+    case VISCA_IP_COMMAND:
+    case VISCA_IP_INQUIRY:
+      if ((seq-sim->last_seq>VISCA_SIM_SEQ_WINDOW)&&(sim->last_seq-seq>=VISCA_SIM_SEQ_WINDOW))
+	{
+	  _VISCA_sim_ip_header(out, VISCA_IP_CONTROL_REPLY, 2, seq);
+	  out[VISCA_IP_HEADER_SIZE]=VISCA_IP_ERROR;
+	  out[VISCA_IP_HEADER_SIZE+1]=VISCA_IP_ERROR_SEQUENCE;
+	  *out_length=VISCA_IP_HEADER_SIZE+2;
+	  break;
+	}
+      if ((int32_t)(seq-sim->last_seq)>0)
+	sim->last_seq=seq;
+
+      sim->seq=seq;
+      _VISCA_sim_packet(sim, msg, length, now);
+      sim->seq=0;
+      break;
+    }
+}
+
+
+/* Server thread of the UDP mode: answers the client the last datagram
+ * came from.
+ */
+static void *
+_VISCA_sim_serve_udp(void *arg)
+{
+  VISCASim_t *sim=(VISCASim_t *)arg;
+  struct pollfd pfd[2];
+  struct sockaddr_storage from;
+  socklen_t from_length;
+  unsigned char buf[VISCA_IP_HEADER_SIZE+64], out[VISCA_IP_HEADER_SIZE+16];
+  uint32_t now, wait, length, seq;
+  ssize_t ret;
+  int pending;
+
+  pfd[0].fd=sim->fd;
+  pfd[0].events=POLLIN;
+  pfd[1].fd=sim->wake[0];
+  pfd[1].events=POLLIN;
+
+  for (;;)
+    {
+      pthread_mutex_lock(&sim->lock);
+      now=_VISCA_get_time();
+      while (_VISCA_sim_pop(sim, now, &out[VISCA_IP_HEADER_SIZE], &length, &seq))
+	{
+	  _VISCA_sim_ip_header(out, VISCA_IP_REPLY, length, seq);
+	  sendto(sim->fd, out, VISCA_IP_HEADER_SIZE+length, 0,
+		 (struct sockaddr *)&sim->peer, sim->peer_length);
+	  now=_VISCA_get_time();
+	}
+      pending=_VISCA_sim_due(sim, now, &wait);
+      pthread_mutex_unlock(&sim->lock);
+
+      ret=poll(pfd, 2, pending ? (int)((wait+999)/1000) : -1);
+      if (ret<0)
+	{
+	  if (errno==EINTR)
+	    continue;
+	  break;
+	}
+      if (pfd[1].revents)
+	break;
+      if (!(pfd[0].revents&POLLIN))
+	continue;
+
+      from_length=sizeof(from);
+      ret=recvfrom(sim->fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_length);
+      if ((ret<VISCA_IP_HEADER_SIZE)||
+	  ((uint32_t)((buf[2]<<8)|buf[3])!=(uint32_t)ret-VISCA_IP_HEADER_SIZE))
+	continue;
+
+      now=_VISCA_get_time();
+      pthread_mutex_lock(&sim->lock);
+      sim->datagrams++;
+      if ((sim->drop>0)&&(sim->datagrams%sim->drop==0))
+	{
+	  pthread_mutex_unlock(&sim->lock);
+	  continue;
+	}
+      memcpy(&sim->peer, &from, from_length);
+      sim->peer_length=from_length;
+      _VISCA_sim_datagram(sim, buf, ret, now, out, &length);
+      if (length>0)
+	sendto(sim->fd, out, length, 0, (struct sockaddr *)&sim->peer, sim->peer_length);
+      pthread_mutex_unlock(&sim->lock);
+    }
+
+  return NULL;
+}
+
+
+static unsigned int
+_VISCA_sim_start(VISCASim_t *sim, int fd, void *(*serve)(void *))
+{
+  if (pipe(sim->wake)!=0)
+    return VISCA_FAILURE;
+
+  sim->fd=fd;
+  sim->in_length=0;
+  if (pthread_create(&sim->server, NULL, serve, sim)!=0)
+    {
+      close(sim->wake[0]);
+      close(sim->wake[1]);
+      return VISCA_FAILURE;
+    }
+  sim->running=1;
+
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_sim_socket_open(VISCAInterface_t *iface, const char *name)
+{
+  VISCASim_t *sim=(VISCASim_t *)iface->transport_data;
+  int sv[2];
+
+  if (sim->running||(socketpair(AF_UNIX, SOCK_STREAM, 0, sv)!=0))
+    return VISCA_FAILURE;
+
+  if (_VISCA_sim_start(sim, sv[0], _VISCA_sim_serve)!=VISCA_SUCCESS)
+    {
+      close(sv[0]);
+      close(sv[1]);
+      return VISCA_FAILURE;
+    }
+  iface->port_fd=sv[1];
+
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_sim_pty_open(VISCAInterface_t *iface, const char *name)
+{
+  VISCASim_t *sim=(VISCASim_t *)iface->transport_data;
+  char device_name[64];
+
+  if (VISCA_sim_start_pty(sim, device_name, sizeof(device_name))!=VISCA_SUCCESS)
+    return VISCA_FAILURE;
+
+  // the library side is set up like any serial port
+  if (VISCA_serial_transport.open(iface, device_name)!=VISCA_SUCCESS)
+    {
+      VISCA_sim_stop(sim);
+      return VISCA_FAILURE;
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_sim_udp_open(VISCAInterface_t *iface, const char *name)
+{
+  VISCASim_t *sim=(VISCASim_t *)iface->transport_data;
+  char address[32];
+  uint32_t port;
+
+  if (VISCA_sim_start_udp(sim, 0, &port)!=VISCA_SUCCESS)
+    return VISCA_FAILURE;
+
+  snprintf(address, sizeof(address), "127.0.0.1:%u", port);
+  if (_VISCA_ip_open(iface, address)!=VISCA_SUCCESS)
+    {
+      VISCA_sim_stop(sim);
+      return VISCA_FAILURE;
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+static unsigned int
+_VISCA_sim_stream_close(VISCAInterface_t *iface)
+{
+  uint32_t err;
+
+  err=_VISCA_fd_close(iface);
+  VISCA_sim_stop((VISCASim_t *)iface->transport_data);
+
+  return err;
+}
+
+
+static const VISCATransport_t _VISCA_sim_socket_transport = {
+  "sim-socketpair",
+  _VISCA_sim_socket_open,
+  _VISCA_fd_write,
+  _VISCA_fd_read_frame,
+  _VISCA_wait_input,
+  _VISCA_sim_stream_close
+};
+
+
+static const VISCATransport_t _VISCA_sim_pty_transport = {
+  "sim-pty",
+  _VISCA_sim_pty_open,
+  _VISCA_fd_write,
+  _VISCA_fd_read_frame,
+  _VISCA_wait_input,
+  _VISCA_sim_stream_close
+};
+
+
+static const VISCATransport_t _VISCA_sim_udp_transport = {
+  "sim-udp",
+  _VISCA_sim_udp_open,
+  _VISCA_ip_write,
+  _VISCA_ip_read_frame,
+  _VISCA_wait_input,
+  _VISCA_sim_stream_close
+};
+
+
+/***********************************/
+/*       SYSTEM  FUNCTIONS         */
+/***********************************/
+
+void
+VISCA_sim_init(VISCASim_t *sim, uint32_t cameras)
+{
+  pthread_condattr_t cattr;
+  uint32_t i;
+
+  memset(sim, 0, sizeof(VISCASim_t));
+
+  sim->cameras=(cameras<1) ? 1 : (cameras>7) ? 7 : cameras;
+  sim->model=VISCA_MODEL_EX47xL;
+  sim->ack_delay=1000;
+  sim->completion_delay=2000;
+  sim->inquiry_delay=1000;
+  sim->zoom_rate=(VISCA_SIM_ZOOM_MAX-VISCA_SIM_ZOOM_MIN)/2;        // 2 s end to end
+  sim->focus_rate=(VISCA_SIM_FOCUS_MAX-VISCA_SIM_FOCUS_MIN)/2;
+  sim->pan_rate=100;
+  sim->tilt_rate=100;
+
+  for (i=0; i<7; i++)
+    {
+      sim->camera[i].power=1;
+      sim->camera[i].focus.from=VISCA_SIM_FOCUS_MIN;
+      sim->camera[i].focus.to=VISCA_SIM_FOCUS_MIN;
+    }
+
+  sim->fd=-1;
+  sim->slave=-1;
+  sim->wake[0]=-1;
+  sim->wake[1]=-1;
+
+  pthread_mutex_init(&sim->lock, NULL);
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+  pthread_cond_init(&sim->changed, &cattr);
+  pthread_condattr_destroy(&cattr);
+}
+
+
+void
+VISCA_sim_destroy(VISCASim_t *sim)
+{
+  if (sim->running)
+    VISCA_sim_stop(sim);
+  pthread_cond_destroy(&sim->changed);
+  pthread_mutex_destroy(&sim->lock);
+}
+
+
+uint32_t
+VISCA_open_sim(VISCAInterface_t *iface, VISCASim_t *sim, uint32_t mode)
+{
+  iface->transport_data=sim;
+
+  switch (mode)
+    {
+    case VISCA_SIM_DIRECT:
+      return VISCA_open_transport(iface, &_VISCA_sim_direct_transport, NULL);
+    case VISCA_SIM_SOCKETPAIR:
+      return VISCA_open_transport(iface, &_VISCA_sim_socket_transport, NULL);
+    case VISCA_SIM_PTY:
+      return VISCA_open_transport(iface, &_VISCA_sim_pty_transport, NULL);
+    case VISCA_SIM_UDP:
+      return VISCA_open_transport(iface, &_VISCA_sim_udp_transport, NULL);
+    default:
+      return VISCA_FAILURE;
+    }
+}
+
+
+uint32_t
+VISCA_sim_start_pty(VISCASim_t *sim, char *device_name, uint32_t size)
+{
+  struct termios options;
+  int fd, slave;
+
+  if (sim->running)
+    return VISCA_FAILURE;
+
+  fd=posix_openpt(O_RDWR|O_NOCTTY);
+  if (fd==-1)
+    return VISCA_FAILURE;
+  if ((grantpt(fd)!=0)||(unlockpt(fd)!=0)||
+      (ptsname_r(fd, sim->device_name, sizeof(sim->device_name))!=0))
+    {
+      close(fd);
+      return VISCA_FAILURE;
+    }
+
+  // keep the slave open, so that the master stays usable between
+  // sessions, and raw until the line is set up
+  slave=open(sim->device_name, O_RDWR|O_NOCTTY);
+  if (slave==-1)
+    {
+      close(fd);
+      return VISCA_FAILURE;
+    }
+  tcgetattr(slave, &options);
+  cfmakeraw(&options);
+  tcsetattr(slave, TCSANOW, &options);
+
+  if (_VISCA_sim_start(sim, fd, _VISCA_sim_serve)!=VISCA_SUCCESS)
+    {
+      close(slave);
+      close(fd);
+      return VISCA_FAILURE;
+    }
+  sim->slave=slave;
+
+  if (size>0)
+    {
+      strncpy(device_name, sim->device_name, size-1);
+      device_name[size-1]=0;
+    }
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_sim_start_udp(VISCASim_t *sim, uint32_t port, uint32_t *bound)
+{
+  struct sockaddr_in addr;
+  socklen_t length=sizeof(addr);
+  int fd;
+
+  if (sim->running)
+    return VISCA_FAILURE;
+
+  fd=socket(AF_INET, SOCK_DGRAM|SOCK_CLOEXEC, 0);
+  if (fd==-1)
+    return VISCA_FAILURE;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family=AF_INET;
+  addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  addr.sin_port=htons(port);
+  if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr))!=0)||
+      (getsockname(fd, (struct sockaddr *)&addr, &length)!=0))
+    {
+      close(fd);
+      return VISCA_FAILURE;
+    }
+
+  sim->last_seq=0;
+  sim->peer_length=0;
+  if (_VISCA_sim_start(sim, fd, _VISCA_sim_serve_udp)!=VISCA_SUCCESS)
+    {
+      close(fd);
+      return VISCA_FAILURE;
+    }
+
+  if (bound!=NULL)
+    *bound=ntohs(addr.sin_port);
+
+  return VISCA_SUCCESS;
+}
+
+
+uint32_t
+VISCA_sim_stop(VISCASim_t *sim)
+{
+  if (!sim->running)
+    return VISCA_FAILURE;
+
+  if (write(sim->wake[1], "", 1)!=1)
+    return VISCA_FAILURE;
+  pthread_join(sim->server, NULL);
+
+  close(sim->wake[0]);
+  close(sim->wake[1]);
+  close(sim->fd);
+  if (sim->slave!=-1)
+    close(sim->slave);
+  sim->wake[0]=-1;
+  sim->wake[1]=-1;
+  sim->fd=-1;
+  sim->slave=-1;
+  sim->running=0;
+
+  return VISCA_SUCCESS;
+}
@@ -33,6 +33,7 @@ void _VISCA_append_byte(VISCAPacket_t *packet, unsigned char byte);
 void _VISCA_init_packet(VISCAPacket_t *packet);
 unsigned int _VISCA_get_reply(VISCAInterface_t *iface, VISCACamera_t *camera);
 unsigned int _VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
+VISCARequest_t *_VISCA_dispatch_reply(VISCAInterface_t *iface);
 
 
 /* Implementation of the platform specific code. The following functions must
@@ -41,7 +42,12 @@ unsigned int _VISCA_send_packet_with_reply(VISCAInterface_t *iface, VISCACamera_
  * unsigned int _VISCA_write_packet_data(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
  * unsigned int _VISCA_send_packet(VISCAInterface_t *iface, VISCACamera_t *camera, VISCAPacket_t *packet);
  * unsigned int _VISCA_get_packet(VISCAInterface_t *iface);
+ * unsigned int _VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout);
+ * void _VISCA_lock(VISCAInterface_t *iface);
+ * void _VISCA_unlock(VISCAInterface_t *iface);
+ * uint32_t _VISCA_get_time(void);
  * unsigned int VISCA_open_serial(VISCAInterface_t *iface, const char *device_name);
+ * unsigned int VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags);
  * unsigned int VISCA_close_serial(VISCAInterface_t *iface);
  * 
  */
@@ -117,7 +123,12 @@ _VISCA_get_packet(VISCAInterface_t *iface)
 
   // wait for message
   rc=ReadFile(iface->port_fd, iface->ibuf, 1, &iBytesRead, NULL);
-  if ( !rc || iBytesRead==0 )
+  if ( rc && iBytesRead==0 )
+  {
+	  _RPTF0(_CRT_WARN,"ReadFile timed out.\n");
+      return VISCA_TIMEOUT;
+  }
+  if ( !rc )
   {
       // Obtain the error code
       //m_lLastError = ::GetLastError();
@@ -148,12 +159,60 @@ _VISCA_get_packet(VISCAInterface_t *iface)
 
 
 
+/* Monotonic time in us, with the resolution of the system tick.
+ */
+uint32_t
+_VISCA_get_time(void)
+{
+  return GetTickCount()*1000;
+}
+
+
+
+/* Wait for the next reply and route it to its request.
+ */
+uint32_t
+_VISCA_wait_reply(VISCAInterface_t *iface, uint32_t timeout)
+{
+  uint32_t err;
+
+  err=_VISCA_get_packet(iface);
+  if (err!=VISCA_SUCCESS)
+     return err;
+  _VISCA_dispatch_reply(iface);
+
+  return VISCA_SUCCESS;
+}
+
+
+/* There is only one thread of control here, nothing to lock.
+ */
+void
+_VISCA_lock(VISCAInterface_t *iface)
+{
+}
+
+
+void
+_VISCA_unlock(VISCAInterface_t *iface)
+{
+}
+
+
+
 /***********************************/
 /*       SYSTEM  FUNCTIONS         */
 /***********************************/
 
 uint32_t
 VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
+{
+  return VISCA_open_serial_ext(iface, device_name, 9600, VISCA_SERIAL_DEFAULT);
+}
+
+
+uint32_t
+VISCA_open_serial_ext(VISCAInterface_t *iface, const char *device_name, uint32_t baud, uint32_t flags)
 {
   BOOL     m_bPortReady;
   HANDLE   m_hCom;
@@ -180,26 +239,34 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
   
   // Port settings are specified in a Data Communication Block (DCB). The easiest way to initialize a DCB is to call GetCommState to fill in its default values, override the values that you want to change and then call SetCommState to set the values.
   m_bPortReady = GetCommState(m_hCom, &m_dcb);
-  m_dcb.BaudRate = 9600;
+  m_dcb.BaudRate = baud;
   m_dcb.ByteSize = 8;
   m_dcb.Parity = NOPARITY;
-  m_dcb.StopBits = ONESTOPBIT;
+  m_dcb.StopBits = (flags & VISCA_SERIAL_STOPB2) ? TWOSTOPBITS : ONESTOPBIT;
   m_dcb.fAbortOnError = TRUE;
 
   // =========================================
   // (jd) added to get a complete setup...
-  m_dcb.fOutxCtsFlow = FALSE;		     // Disable CTS monitoring
+  m_dcb.fOutxCtsFlow = (flags & VISCA_SERIAL_CRTSCTS) ? TRUE : FALSE; // CTS monitoring
   m_dcb.fOutxDsrFlow = FALSE;		     // Disable DSR monitoring
   m_dcb.fDtrControl = DTR_CONTROL_DISABLE;   // Disable DTR monitoring
   m_dcb.fOutX = FALSE;			     // Disable XON/XOFF for transmission
   m_dcb.fInX = FALSE;			     // Disable XON/XOFF for receiving
-  m_dcb.fRtsControl = RTS_CONTROL_DISABLE;   // Disable RTS (Ready To Send)
+  m_dcb.fRtsControl = (flags & VISCA_SERIAL_CRTSCTS) ?
+    RTS_CONTROL_HANDSHAKE : RTS_CONTROL_DISABLE; // RTS (Ready To Send)
   m_dcb.fBinary = TRUE;			     // muss immer "TRUE" sein!
   m_dcb.fErrorChar = FALSE;
   m_dcb.fNull = FALSE;
   // =========================================
  
   m_bPortReady = SetCommState(m_hCom, &m_dcb);
+  if (!m_bPortReady)
+  {
+      _RPTF1(_CRT_WARN,"unable to set baud rate %d\n",baud);
+      CloseHandle(m_hCom);
+      iface->port_fd = NULL;
+      return VISCA_FAILURE;
+  }
   
 
   // =========================================
@@ -230,7 +297,17 @@ VISCA_open_serial(VISCAInterface_t *iface, const char *device_name)
 
   // If all of these API's were successful then the port is ready for use.
   iface->port_fd = m_hCom;
+  iface->baud = baud;
   iface->address = 0;
+  iface->timeout = 0;
+  iface->retry_max = 0;
+  iface->retry_backoff = 0;
+  iface->cache = NULL;
+  iface->completion = NULL;
+  iface->write_tag = 0;
+  iface->reply_tag = 0;
+  iface->requests = NULL;
+  memset(&iface->stats, 0, sizeof(iface->stats));
 
   return VISCA_SUCCESS;
 }